@@ -14,6 +14,9 @@
 	
 	Other various defines:
 	- \#define TOU_LLIST_SINGLE_ELEM
+	- \#define TOU_NO_SIMD (disables SSE2/AVX2/AVX-512 code paths)
+	- \#define TOU_NO_THREADS (parallel functions run on the calling thread)
+	- \#define _DEFAULT_SOURCE with strict -std= modes (see the note at _TOU_HAVE_PREAD)
 	
 	Things:
 	- full linked list impl (todo: improve/cleanup error checking)
@@ -37,6 +40,9 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <errno.h>
 
 /* == Debug options and helpers == */
 /**
@@ -93,7 +99,22 @@
 #else
 #include <unistd.h>
 #include <fcntl.h> // O_WRONLY
+#include <sys/stat.h> // fstat
+#include <sys/mman.h> // mmap
 #define _TOU_DEVNULL_FILE "/dev/null"
+// Strict ISO modes (ex. -std=c99) make the POSIX headers hide pread() and madvise()
+// unless POSIX.1-2008 is requested with -D_DEFAULT_SOURCE or -D_POSIX_C_SOURCE=200809L.
+// Without them positional tou_block_reader reads fall back to lseek() + read(), which
+// can't be shared between threads, and tou_map_file() skips its access hints.
+#if !defined(__STRICT_ANSI__) || (defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200809L) || (defined(_XOPEN_SOURCE) && _XOPEN_SOURCE >= 500)
+#define _TOU_HAVE_PREAD 1
+#endif
+#endif
+
+// x86 SIMD kernels are compiled with target attributes and selected at runtime
+#if !defined(TOU_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define _TOU_SIMD_X86 1
+#include <immintrin.h>
 #endif
 /** @endcond */
 
@@ -114,6 +135,11 @@
 #define TOU_DEFAULT_BLOCKSIZE 4096
 #endif
 
+/** @brief Smallest piece of a buffer handed to a single thread by parallel functions */
+#ifndef TOU_PARALLEL_MIN_CHUNK
+#define TOU_PARALLEL_MIN_CHUNK (256 * 1024)
+#endif
+
 /** @brief Data format version when exporting INI to JSON */
 #define TOU_JSON_DATA_VER "1.0"
 
@@ -141,6 +167,9 @@
 */
 #ifndef TOU_IS_BLANK
 #define TOU_IS_BLANK(c) ((c)==' ' || (c)=='\n' || (c)=='\r' || (c)=='\t')
+/** @cond */
+#define _TOU_IS_BLANK_DEFAULT 1 // SIMD trimming knows only this set
+/** @endcond */
 #endif
 
 /**
@@ -403,7 +432,7 @@ char* tou_trim_front_pure(char* str);
 char* tou_trim_back_pure(char* str);
 
 /**
-	@brief Converts all characters in `str` to lowercase in-place.
+	@brief Converts all (ASCII) characters in `str` to lowercase in-place.
 
 	@param[in,out] str String to convert
 	@return Pointer to the same string
@@ -411,7 +440,7 @@ char* tou_trim_back_pure(char* str);
 char* tou_slower(char* str);
 
 /**
-	@brief Converts all characters in `str` to uppercase in-place.
+	@brief Converts all (ASCII) characters in `str` to uppercase in-place.
 
 	@param[in,out] str String to convert
 	@return Pointer to the same string
@@ -430,6 +459,8 @@ char* tou_supper(char* str);
 	char ss[] = "aeiouoiea/1/2/3";
 	```
 
+	Replacing '\0' does nothing; the string ends there.
+
 	@param[in] ss String in which to replace occurences
 	@param[in] oldch Character to replace
 	@param[in] newch Character with which to replace `oldch`
@@ -437,6 +468,27 @@ char* tou_supper(char* str);
 */
 char* tou_replace_ch(char* ss, char oldch, char newch);
 
+/**
+	@brief Replaces every byte `c` of the first `len` bytes of `str` with `table[c]`, in-place.
+
+	One pass does what would otherwise take chained ::tou_slower, ::tou_replace_ch
+	etc. calls. `str` doesn't need to be NUL-terminated (a NUL is mapped like any other byte).
+
+	```c
+	unsigned char table[256];
+	for (int i = 0; i < 256; i++)
+		table[i] = (i >= 'A' && i <= 'Z') ? i | 0x20 : i;
+	table['\t'] = ' ';
+	tou_stranslate(line, line_len, table);
+	```
+
+	@param[in,out] str Bytes to translate
+	@param[in] len Count of bytes to translate
+	@param[in] table Byte to byte mapping
+	@return Original `str` pointer
+*/
+char* tou_stranslate(char* str, size_t len, const unsigned char table[256]);
+
 /**
 	@brief Finds start of substring(keyword) in the given char*.
 	
@@ -449,6 +501,16 @@ char* tou_sfind(const char* str, const char* kwd);
 /**
 	@brief Finds start of substring(keyword) in the given char*, looking
 	at a max of `maxlen` characters.
+
+	Behaves like memmem(): `str` is treated as exactly `maxlen` bytes and
+	doesn't have to be NUL-terminated (a '\0' inside the range is searched
+	through like any other byte). An empty keyword matches at `str`.
+
+	Uses the Two-Way algorithm (Crochemore-Perrin) so the search runs in
+	linear time regardless of input, using constant extra space.
+	On x86 an SSE2/AVX2/AVX-512 kernel (picked at first call) filters
+	candidate positions by the keyword's first and last byte and hands
+	over to Two-Way if it starts seeing too many false candidates.
 	
 	@param[in] str Source string
 	@param[in] kwd Which keyword to search for
@@ -457,10 +519,87 @@ char* tou_sfind(const char* str, const char* kwd);
 */
 char* tou_sfind_n(const char* str, const char* kwd, size_t maxlen);
 
+/**
+	@brief Like ::tou_sfind but ignores (ASCII) case.
+
+	Case is folded on the fly, neither string is copied or modified.
+
+	@param[in] str Source string
+	@param[in] kwd Which keyword to search for
+	@return Pointer to the beginning of the keyword in the text or NULL
+*/
+char* tou_sfind_ci(const char* str, const char* kwd);
+
+/**
+	@brief Like ::tou_sfind_n but ignores (ASCII) case.
+
+	@param[in] str Source string
+	@param[in] kwd Which keyword to search for
+	@param[in] maxlen Looks only at the first `maxlen` characters
+	@return Pointer to the beginning of the keyword in the text or NULL
+*/
+char* tou_sfind_ci_n(const char* str, const char* kwd, size_t maxlen);
+
+/**
+	@brief Keyword precompiled for repeated searching with ::tou_sfind_pat
+	and friends.
+
+	Holds the keyword length, its Two-Way critical factorization and a
+	Horspool skip table so none of it is recomputed per search.
+	Create with ::tou_pattern_new and release with ::tou_pattern_destroy.
+*/
+typedef struct {
+	char* kwd;          /**< copy of the keyword                     */
+	size_t len;         /**< keyword length                          */
+	size_t tw_ms;       /**< Two-Way critical position - 1           */
+	size_t tw_p;        /**< Two-Way period / shift                  */
+	size_t tw_mem0;     /**< Two-Way memory after a full-period shift */
+	size_t shift[256];  /**< Horspool shift keyed by the last byte   */
+} tou_pattern;
+
+/**
+	@brief Compiles `kwd` into a ::tou_pattern.
+
+	@param[in] kwd Keyword to precompile (copied)
+	@return Newly allocated pattern or NULL on error
+*/
+tou_pattern* tou_pattern_new(const char* kwd);
+
+/**
+	@brief Frees a pattern created by ::tou_pattern_new.
+
+	@param[in] pat Pattern, may be NULL
+*/
+void tou_pattern_destroy(tou_pattern* pat);
+
+/**
+	@brief Like ::tou_sfind but uses a precompiled pattern.
+
+	@param[in] str Source string
+	@param[in] pat Compiled keyword
+	@return Pointer to the beginning of the keyword in the text or NULL
+*/
+char* tou_sfind_pat(const char* str, const tou_pattern* pat);
+
+/**
+	@brief Like ::tou_sfind_n but uses a precompiled pattern.
+
+	Short keywords go through the same SIMD kernels as ::tou_sfind_n, long
+	ones use Two-Way accelerated with the Horspool skip table.
+
+	@param[in] str Source buffer
+	@param[in] pat Compiled keyword
+	@param[in] maxlen Length of `str`
+	@return Pointer to the beginning of the keyword in the text or NULL
+*/
+char* tou_sfind_pat_n(const char* str, const tou_pattern* pat, size_t maxlen);
+
 /**
 	@brief Like ::tou_sfind but searches for more than one string at a time.
 
 	`found_idx` may be NULL if you don't need to know which keyword was found.
+	Reports the leftmost-longest match. Keywords are compiled into a temporary
+	::tou_kwset on each call; use ::tou_kwset_find when searching repeatedly.
 
 	@param[in] str String to search in
 	@param[in] kwds Array of char* keywords to search for
@@ -474,6 +613,8 @@ char* tou_sfind_multiple(const char* str, const char** kwds, int n_kwds, int* fo
 	@brief Like ::tou_sfind_n but searches for more than one string at a time.
 
 	`found_idx` may be NULL if you don't need to know which keyword was found.
+	Searching stops at `maxlen` characters or at the first '\0', whichever
+	comes first. Reports the leftmost-longest match.
 
 	@param[in] str String to search in
 	@param[in] kwds Array of char* keywords to search for
@@ -520,6 +661,306 @@ void tou_sfind_iter_multiple(const char* src, const char* kwds[], int n_kwds, to
 */
 void tou_sfind_iter_multiple_n(const char* src, const char* kwds[], int n_kwds, tou_func3 cb, void* userdata, size_t maxlen);
 
+/**
+	@brief Compiled set of keywords (Aho-Corasick automaton) for finding
+	any of them in a single pass over the text.
+
+	Transitions are stored in one flat table indexed by
+	`state * n_classes + classes[byte]`, where bytes which don't appear in any
+	keyword share a single class, keeping the table small for large sets.
+	Create with ::tou_kwset_new and release with ::tou_kwset_destroy.
+*/
+typedef struct tou_kwset {
+	char** kwds;                /**< copies of the keywords                        */
+	size_t* kwd_lens;           /**< length of each keyword                        */
+	int n_kwds;                 /**< keyword count                                 */
+	size_t max_len;             /**< length of the longest keyword                 */
+	int n_states;               /**< state count (rows in `delta`)                 */
+	int n_classes;              /**< byte class count (columns in `delta`)         */
+	unsigned char classes[256]; /**< byte -> class map                             */
+	int* delta;                 /**< flat transition table                         */
+	size_t* depth;              /**< length of the prefix each state represents    */
+	int* term;                  /**< keyword ending in this state, or -1           */
+	int* dict;                  /**< closest suffix state ending a keyword, or -1  */
+	char fold_case;             /**< ASCII case is ignored (::tou_kwset_new_ci)    */
+} tou_kwset;
+
+/**
+	@brief Compiles keywords into a ::tou_kwset.
+
+	Keywords are copied. NULL and empty keywords are kept (so indices
+	line up with `kwds`) but never match.
+
+	@param[in] kwds Array of char* keywords
+	@param[in] n_kwds Count of keywords in `kwds`
+	@return Newly allocated keyword set or NULL on error
+*/
+tou_kwset* tou_kwset_new(const char** kwds, int n_kwds);
+
+/**
+	@brief Like ::tou_kwset_new but the set matches keywords regardless
+	of (ASCII) case.
+
+	Upper and lower case letters simply share a byte class, so searching
+	costs exactly the same as with a case-sensitive set.
+
+	@param[in] kwds Array of char* keywords
+	@param[in] n_kwds Count of keywords in `kwds`
+	@return Newly allocated keyword set or NULL on error
+*/
+tou_kwset* tou_kwset_new_ci(const char** kwds, int n_kwds);
+
+/**
+	@brief Frees a keyword set created by ::tou_kwset_new.
+
+	@param[in] set Keyword set, may be NULL
+*/
+void tou_kwset_destroy(tou_kwset* set);
+
+/**
+	@brief Finds the leftmost-longest occurence of any keyword in `set`.
+
+	Among matches starting at the same position the longest one is chosen;
+	identical keywords resolve to the lowest index.
+
+	@param[in] set Compiled keyword set
+	@param[in] str String to search in
+	@param[out] found_idx Index of the found keyword, -1 if none; may be NULL
+	@return Pointer to the beginning of the match or NULL
+*/
+char* tou_kwset_find(const tou_kwset* set, const char* str, int* found_idx);
+
+/**
+	@brief Like ::tou_kwset_find but looks at exactly `maxlen` bytes of `str`
+	(memmem semantics, `str` doesn't have to be NUL-terminated).
+
+	@param[in] set Compiled keyword set
+	@param[in] str Buffer to search in
+	@param[in] maxlen Length of `str`
+	@param[out] found_idx Index of the found keyword, -1 if none; may be NULL
+	@return Pointer to the beginning of the match or NULL
+*/
+char* tou_kwset_find_n(const tou_kwset* set, const char* str, size_t maxlen, int* found_idx);
+
+/**
+	@brief Calls user function for each non-overlapping leftmost-longest
+	occurence of keywords from `set`, in one pass over `src`.
+
+	The callback receives the same args as with ::tou_sfind_iter_multiple
+	(`kwd` points to the set's copy of the keyword).
+
+	@param[in] set Compiled keyword set
+	@param[in] src String to search in
+	@param[in] cb User callback called for each found token
+	@param[in] userdata User data passed to callback
+*/
+void tou_kwset_iter(const tou_kwset* set, const char* src, tou_func3 cb, void* userdata);
+
+/**
+	@brief Like ::tou_kwset_iter but looks at exactly `maxlen` bytes of `src`.
+
+	@param[in] set Compiled keyword set
+	@param[in] src Buffer to search in
+	@param[in] cb User callback called for each found token
+	@param[in] userdata User data passed to callback
+	@param[in] maxlen Length of `src`
+*/
+void tou_kwset_iter_n(const tou_kwset* set, const char* src, tou_func3 cb, void* userdata, size_t maxlen);
+
+/**
+	@brief Single keyword match found in a text or a stream.
+*/
+typedef struct {
+	size_t offset; /**< offset of the match from the start of the text/stream */
+	size_t len;    /**< length of the matched keyword                          */
+	int idx;       /**< index of the matched keyword                           */
+} tou_match;
+
+/**
+	@brief Output list of matches filled by ::tou_sfind_all and friends.
+
+	Either point `items` to your own array of `cap` elements, or zero it
+	and set `growable` to have `items` (re)allocated as needed (free it
+	yourself afterwards). Functions overwrite the list from the start.
+*/
+typedef struct {
+	tou_match* items; /**< match array                                  */
+	size_t count;     /**< matches stored in `items`                    */
+	size_t cap;       /**< capacity of `items`                          */
+	char growable;    /**< may `items` be realloc()'d to fit everything */
+} tou_match_list;
+
+/**
+	@brief Finds all non-overlapping occurences of `kwd` in `str`.
+
+	Returns the total number of matches. If `out` is NULL matches are only
+	counted; if it's a fixed-size list that is too small, only the first
+	`out->cap` are stored but all are still counted, so the return value
+	can be used to size the array and call again.
+
+	@param[in] str String to search in
+	@param[in] kwd Keyword to search for
+	@param[out] out Where to store matches (`.idx` is always 0), may be NULL
+	@return Total number of matches
+*/
+size_t tou_sfind_all(const char* str, const char* kwd, tou_match_list* out);
+
+/**
+	@brief Like ::tou_sfind_all but looks at exactly `maxlen` bytes of `str`.
+
+	@param[in] str Buffer to search in
+	@param[in] kwd Keyword to search for
+	@param[in] maxlen Length of `str`
+	@param[out] out Where to store matches, may be NULL
+	@return Total number of matches
+*/
+size_t tou_sfind_all_n(const char* str, const char* kwd, size_t maxlen, tou_match_list* out);
+
+/**
+	@brief Finds all non-overlapping leftmost-longest occurences of keywords
+	in `set`; see ::tou_sfind_all for how `out` is filled.
+
+	@param[in] str String to search in
+	@param[in] set Compiled keyword set
+	@param[out] out Where to store matches, may be NULL
+	@return Total number of matches
+*/
+size_t tou_sfind_all_multiple(const char* str, const tou_kwset* set, tou_match_list* out);
+
+/**
+	@brief Like ::tou_sfind_all_multiple but looks at exactly `maxlen` bytes of `str`.
+
+	@param[in] str Buffer to search in
+	@param[in] set Compiled keyword set
+	@param[in] maxlen Length of `str`
+	@param[out] out Where to store matches, may be NULL
+	@return Total number of matches
+*/
+size_t tou_sfind_all_multiple_n(const char* str, const tou_kwset* set, size_t maxlen, tou_match_list* out);
+
+/**
+	@brief Counts non-overlapping occurences of `kwd` in `str`.
+
+	@param[in] str String to search in
+	@param[in] kwd Keyword to count
+	@return Number of occurences
+*/
+size_t tou_scount(const char* str, const char* kwd);
+
+/**
+	@brief Like ::tou_scount but looks at exactly `maxlen` bytes of `str`.
+
+	@param[in] str Buffer to search in
+	@param[in] kwd Keyword to count
+	@param[in] maxlen Length of `str`
+	@return Number of occurences
+*/
+size_t tou_scount_n(const char* str, const char* kwd, size_t maxlen);
+
+/**
+	@brief Like ::tou_sfind_all_n but splits the buffer between `nthreads`
+	threads.
+
+	Each thread searches its own piece of `str`, overlapping the next one by
+	the keyword length - 1, and the results are merged into a single sorted
+	list which is identical to what ::tou_sfind_all_n returns. Buffers
+	smaller than ::TOU_PARALLEL_MIN_CHUNK are searched on the calling thread.
+
+	@param[in] str Buffer to search in
+	@param[in] kwd Keyword to search for
+	@param[in] maxlen Length of `str`
+	@param[out] out Where to store matches, may be NULL
+	@param[in] nthreads Thread count, 0 to use one per CPU
+	@return Total number of matches
+*/
+size_t tou_sfind_all_parallel(const char* str, const char* kwd, size_t maxlen, tou_match_list* out, int nthreads);
+
+/**
+	@brief Like ::tou_sfind_all_multiple_n but splits the buffer between
+	`nthreads` threads; see ::tou_sfind_all_parallel.
+
+	@param[in] str Buffer to search in
+	@param[in] set Compiled keyword set
+	@param[in] maxlen Length of `str`
+	@param[out] out Where to store matches, may be NULL
+	@param[in] nthreads Thread count, 0 to use one per CPU
+	@return Total number of matches
+*/
+size_t tou_sfind_all_multiple_parallel(const char* str, const tou_kwset* set, size_t maxlen, tou_match_list* out, int nthreads);
+
+/**
+	@brief Resumable state for matching a ::tou_kwset against data arriving
+	in chunks, ex. from ::tou_read_fp_in_blocks.
+
+	Only bytes which may still be part of a match (at most the length of the
+	longest keyword) are carried over between chunks, so memory use doesn't
+	depend on the stream size. Matches are the same non-overlapping
+	leftmost-longest ones ::tou_kwset_iter would report on the whole data,
+	including those straddling chunk boundaries.
+
+	The callback receives the following args:
+	- `match` [in] Pointer to ::tou_match with the absolute stream offset
+	- `kwd` [in] Pointer to the matched keyword
+	- `userdata` [in,out] User data passed at the beginning
+
+	Example:
+	```c
+	tou_kwset_stream st;
+	tou_kwset_stream_init(&st, set, my_match_cb, my_data);
+	tou_read_fp_in_blocks(fp, 0, tou_kwset_stream_cb, &st);
+	tou_kwset_stream_finish(&st);
+	```
+*/
+typedef struct {
+	const tou_kwset* set; /**< keyword set being matched                      */
+	tou_func3 cb;         /**< called for each match                          */
+	void* userdata;       /**< passed to `cb`                                 */
+	char* carry;          /**< bytes retained from previous chunks            */
+	size_t carry_len;     /**< used length of `carry`                         */
+	size_t carry_cap;     /**< allocated size of `carry`                      */
+	size_t offset;        /**< stream offset of `carry[0]`                    */
+	char stopped;         /**< set once `cb` returned ::TOU_BREAK             */
+} tou_kwset_stream;
+
+/**
+	@brief Initializes streaming state for matching `set`.
+
+	@param[out] st State to initialize
+	@param[in] set Compiled keyword set, must outlive `st`
+	@param[in] cb User callback called for each match
+	@param[in] userdata User data passed to callback
+*/
+void tou_kwset_stream_init(tou_kwset_stream* st, const tou_kwset* set, tou_func3 cb, void* userdata);
+
+/**
+	@brief Feeds the next chunk of the stream.
+
+	@param[in,out] st Streaming state
+	@param[in] data Chunk data (no need for NUL)
+	@param[in] len Chunk length
+	@return ::TOU_BREAK if callback stopped matching (or on error), ::TOU_CONTINUE otherwise
+*/
+int tou_kwset_stream_feed(tou_kwset_stream* st, const char* data, size_t len);
+
+/**
+	@brief Signals the end of the stream; reports matches still pending in the
+	carried over bytes and releases internal memory.
+
+	@param[in,out] st Streaming state
+*/
+void tou_kwset_stream_finish(tou_kwset_stream* st);
+
+/**
+	@brief Block callback for ::tou_read_fp_in_blocks which feeds each block
+	to the ::tou_kwset_stream passed as `userdata`.
+
+	@param[in] blockdata Pointer to the beginning of new data
+	@param[in] len Amount of bytes actually read
+	@param[in] userdata Pointer to ::tou_kwset_stream
+	@return Whether to continue with read iterations (::tou_iter_action)
+*/
+void* tou_kwset_stream_cb(void* blockdata, void* len, void* userdata);
+
 /**
 	@brief Splits string using a delimiter that may be longer than one character.
 
@@ -529,6 +970,15 @@ void tou_sfind_iter_multiple_n(const char* src, const char* kwds[], int n_kwds,
 */
 tou_llist_t* tou_split(char* str, const char* delim);
 
+/**
+	@brief Like ::tou_split but with a precompiled delimiter.
+
+	@param[in] str String to be split
+	@param[in] delim Compiled delimiter
+	@return Linked list containing tokens
+*/
+tou_llist_t* tou_split_pat(char* str, const tou_pattern* delim);
+
 /**
 	@brief (Re)allocates enough memory for src and appends it to dst.
 
@@ -560,9 +1010,12 @@ char* tou_sappendch(char* dst, char src);
 	Does not know the size of the original destination and will not
 	consider it!
 
+	The result is a new allocation and `dst` is not freed. Every call
+	copies the whole string, for repeated prepending use ::tou_dbuf.
+
 	@param[in] dst String which will be expanded and copied into
 	@param[in] src String to copy
-	@return Realloc'd pointer with combined strings
+	@return Newly allocated pointer with combined strings
 */
 char* tou_sprepend(char* dst, char* src);
 
@@ -573,9 +1026,11 @@ char* tou_sprepend(char* dst, char* src);
 	Does not know the size of the original destination and will not
 	consider it!
 
+	The result is a new allocation and `dst` is not freed.
+
 	@param[in] dst String which will be expanded and copied into
 	@param[in] src String to copy
-	@return Realloc'd pointer with combined strings
+	@return Newly allocated pointer with combined strings
 */
 char* tou_sprependch(char* dst, char src);
 
@@ -598,8 +1053,8 @@ char* tou_sreplace(char* str, char* repl_str, char* with_str);
  * (until '\0' is found) is copied to the end of the buffer.
  * If parameter `len_ptr` is passed as NULL or set to 0, the whole string will be taken into
  * consideration using strlen. If given, it will also be set to new length after replacing.
- * Cutting off at length is performed by temporarily modifying original string and placing
- * '\0' at that position, which is removed right after no more tokens to be replaced can be found.
+ * The original string is not modified. Matches are counted first so the result is
+ * allocated once, at its exact size (see ::tou_sreplace_inplace to avoid allocating).
  * 
  * [!] If you use this function in a loop and keep reassigning new pointers to it
  *     don't forget the original pointer will be invalid at the end! (either 
@@ -614,6 +1069,115 @@ char* tou_sreplace(char* str, char* repl_str, char* with_str);
  */
 char* tou_sreplace_n(char* str, char* repl_str, char* with_str, size_t* len_ptr);
 
+/**
+ * @brief Like ::tou_sreplace_n but with a precompiled string to replace.
+ * 
+ * @param[in,out] str String to be searched for tokens
+ * @param[in] repl Compiled string to replace
+ * @param[in] with_str String to replace with
+ * @param[in,out] len_ptr Pointer to the length variable
+ * @return Pointer to the newly allocated replaced string
+ */
+char* tou_sreplace_pat(char* str, const tou_pattern* repl, char* with_str, size_t* len_ptr);
+
+/**
+ * @brief Like ::tou_sreplace_n but replaces in place, without allocating.
+ *
+ * Works only when `with_str` is not longer than `repl_str`, so the string can
+ * only shrink; it is compacted in a single pass (the part after `*len_ptr`
+ * is moved along). Otherwise nothing is done and NULL is returned.
+ *
+ * @param[in,out] str String to replace in
+ * @param[in] repl_str String to replace
+ * @param[in] with_str String to replace with, not longer than `repl_str`
+ * @param[in,out] len_ptr Pointer to the length variable (as in ::tou_sreplace_n), may be NULL
+ * @return Original `str` pointer, or NULL if `with_str` is longer than `repl_str`
+ */
+char* tou_sreplace_inplace(char* str, const char* repl_str, const char* with_str, size_t* len_ptr);
+
+/**
+ * @brief Replaces every `from[i]` with `to[i]` in a single left-to-right pass.
+ *
+ * All keywords are searched for at once (see ::tou_kwset); where several
+ * match, the leftmost and then the longest one is replaced. Replaced text is
+ * not searched again. The result is allocated once, at its exact size.
+ *
+ * ```c
+ * const char* from[] = {"{name}", "{count}"};
+ * const char* to[]   = {"world", "42"};
+ * char* out = tou_sreplace_multi("hello {name}, {count} new", from, to, 2);
+ * ```
+ *
+ * @param[in] str String to replace in
+ * @param[in] from Array of strings to replace
+ * @param[in] to Array of replacements for `from` at the same index (NULL is the same as "")
+ * @param[in] n Count of strings in `from` and `to`
+ * @return Pointer to the newly allocated replaced string, or NULL on error
+ */
+char* tou_sreplace_multi(const char* str, const char** from, const char** to, int n);
+
+/**
+ * @brief Like ::tou_sreplace_multi but with a precompiled keyword set, so
+ *        the same set of placeholders can be used for many strings.
+ *
+ * @param[in] str String to replace in
+ * @param[in] set Compiled strings to replace
+ * @param[in] to Array of replacements, indexed like the keywords of `set`
+ * @param[in,out] len_ptr Pointer to the length variable (as in ::tou_sreplace_n), may be NULL
+ * @return Pointer to the newly allocated replaced string, or NULL on error
+ */
+char* tou_sreplace_multi_set(const char* str, const tou_kwset* set, const char** to, size_t* len_ptr);
+
+/**
+ * @brief Like ::tou_sreplace_multi_set but hands the result to a callback
+ *        piece by piece instead of building it in memory.
+ *
+ * The callback receives (piece, (size_t) piece length, userdata) and returns
+ * ::TOU_CONTINUE or ::TOU_BREAK to stop, just like with ::tou_read_fp_in_blocks.
+ * Pieces are unchanged spans of `str` and the replacements themselves.
+ *
+ * @param[in] str Bytes to replace in, don't need to be NUL-terminated
+ * @param[in] len Count of bytes in `str`
+ * @param[in] set Compiled strings to replace
+ * @param[in] to Array of replacements, indexed like the keywords of `set`
+ * @param[in] cb Receives the output
+ * @param[in] userdata Passed to `cb`
+ * @return Count of bytes handed to `cb`
+ */
+size_t tou_sreplace_multi_cb(const char* str, size_t len, const tou_kwset* set, const char** to, tou_func3 cb, void* userdata);
+
+/**
+ * @brief Like ::tou_sreplace_multi_cb but writes the result to a file stream.
+ *
+ * @param[in] str Bytes to replace in, don't need to be NUL-terminated
+ * @param[in] len Count of bytes in `str`
+ * @param[in] set Compiled strings to replace
+ * @param[in] to Array of replacements, indexed like the keywords of `set`
+ * @param[in] fp Stream to write to
+ * @return Count of bytes written
+ */
+size_t tou_sreplace_multi_fp(const char* str, size_t len, const tou_kwset* set, const char** to, FILE* fp);
+
+/**
+ * @brief Replaces every `repl_str` with `with_str` while copying `in` to `out`.
+ *
+ * The input is read with ::tou_read_fp_in_blocks and never held whole: only the
+ * last `strlen(repl_str) - 1` bytes of a block, which may begin a match that
+ * continues in the next one, are carried over. Output is collected in a large
+ * buffer and written out in big chunks, so memory use depends on the block and
+ * buffer sizes only, not on the size of the stream. Matches are the same as
+ * ::tou_sreplace_n would replace on the whole input.
+ *
+ * Stops early if writing fails; check `ferror(out)` to tell that apart.
+ *
+ * @param[in] in Stream to read from
+ * @param[in] out Stream to write to
+ * @param[in] repl_str String to replace
+ * @param[in] with_str String to replace with
+ * @return Count of replacements made
+ */
+size_t tou_sreplace_stream(FILE* in, FILE* out, const char* repl_str, const char* with_str);
+
 /**
 	@brief Checks if length of given string element (.dat1/2)
 	       is zero after trimming it from the start.
@@ -629,1634 +1193,6845 @@ char* tou_sreplace_n(char* str, char* repl_str, char* with_str, size_t* len_ptr)
 	 tou_strlen(tou_trim_front_pure((elem)->dat)) == 0)
 #endif
 
+/**
+	@brief Non-owning view into a string: pointer plus length.
 
-/** @} */
-
+	The bytes don't have to be NUL-terminated, so views can point into
+	read-only or mapped buffers and slices of larger strings. None of the
+	`_sv` functions look for a terminator.
+*/
+typedef struct tou_sv {
+	const char* p; /**< start of the viewed bytes */
+	size_t n;      /**< count of viewed bytes     */
+} tou_sv;
 
-/* == File operations == */
 /**
-	@addtogroup grp_file File operations
-	@{
+	@brief Makes a ::tou_sv out of a string literal without calling strlen.
 */
+#ifndef TOU_SV
+#define TOU_SV(lit) ((tou_sv){ (lit), sizeof(lit) - 1 })
+#endif
 
 /**
-	@brief Reads file in blocks, calling user-provided function for each block.
+	@brief Makes a view of the whole NUL-terminated string (NULL gives an empty view).
 
-	Automatically allocates memory and returns amount read.
-	Function receives 3 parameters:
-	- `data` [in] Pointer to new data
-	- `len` [in] Amount of bytes actually read
-	- `userdata` [in,out] User data provided
+	@param[in] str String to view, may be NULL
+	@return View of the string
+*/
+tou_sv tou_sv_from(const char* str);
 
-	Look into this function's source and/or ::tou_block_store_cb and
-	::tou_block_store_struct for more info about using it.
+/**
+	@brief Makes a view of `n` bytes starting at `p`.
 
-	@param[in] fp FILE* from which data is to be read
-	@param[in] blocksize Size in bytes; set to 0 to use default (::TOU_DEFAULT_BLOCKSIZE)
-	@param[in] cb Function to call for each block
-	@param[in] userdata Custom data to be passed to function
-	@return Total bytes read
+	@param[in] p Start of the bytes
+	@param[in] n Count of the bytes
+	@return View of the bytes
 */
-size_t tou_read_fp_in_blocks(FILE* fp, size_t blocksize, tou_func3 cb, void* userdata);
+tou_sv tou_sv_make(const char* p, size_t n);
 
 /**
-	@addtogroup grp_file_lower Lower file operations
-	@{
+	@brief Returns a newly allocated NUL-terminated copy of the viewed bytes.
+
+	@param[in] sv View to copy
+	@return Pointer to the newly allocated string or NULL
 */
+char* tou_sv_dup(tou_sv sv);
 
 /**
-	@brief Struct containing buffer and count to be used in block-reading
+	@brief Compares two views like strcmp() would compare the strings.
 
-	This struct is automatically instantiated by ::tou_read_file and passed to
-	::tou_read_fp_in_blocks, but may also be used manually for any purpose.
+	@param[in] a First view
+	@param[in] b Second view
+	@return Negative, zero or positive if `a` is less, equal or greater than `b`
 */
-typedef struct {
-	char* buffer; /**< Buffer to append data to */
-	size_t size; /**< Length of the buffer contents */
-} tou_block_store_struct;
+int tou_sv_cmp(tou_sv a, tou_sv b);
 
 /**
-	@brief Appends the given block to the buffer in
-	`tou_block_store_struct` through realloc().
-
-	Memory for '\0' at the end will be allocated, but will not be
-	indicated in `.size` parameter. This function is automatically
-	passed to ::tou_read_fp_in_blocks by ::tou_read_file, but may
-	also be used manually for any purpose.
+	@brief Checks if two views hold the same bytes.
 
-	@param[in] blockdata Pointer to the beginning of new data
-	@param[in] len Amount of bytes actually read
-	@param[in] userdata User data provided
-	@return Whether to continue with read iterations (::tou_iter_action)
+	@param[in] a First view
+	@param[in] b Second view
+	@return 1 if equal, 0 otherwise
 */
-void* tou_block_store_cb(void* blockdata, void* len, void* userdata);
-
-/** @} */
+int tou_sv_eq(tou_sv a, tou_sv b);
 
 /**
-	@brief Reads file from `filename`.
-
-	Automatically allocates memory and optionally
-	returns amount read (may be set to null).
+	@brief Like ::tou_sv_eq but ignores (ASCII) case.
 
-	@param[in] filename Either file name or ""/"stdin" to read from stdin
-	@param[out] read_len Optional pointer to where to store file size
-	@return Pointer to loaded file or NULL if error
+	@param[in] a First view
+	@param[in] b Second view
+	@return 1 if equal, 0 otherwise
 */
-char* tou_read_file(const char* filename, size_t* read_len);
+int tou_sv_eq_ci(tou_sv a, tou_sv b);
 
 /**
-	@brief Reads from `fp`.
-
-	Automatically allocates memory and optionally
-	returns amount read (may be set to null).
+	@brief Checks if the view begins with `prefix`.
 
-	@param[in] fp FILE* to read from
-	@param[out] read_len Optional pointer to where to store file size
-	@return Pointer to loaded data or NULL on error
+	@param[in] sv View to check
+	@param[in] prefix Expected prefix
+	@return 1 if it does, 0 otherwise
 */
-char* tou_read_fp(FILE* fp, size_t* read_len);
+int tou_sv_starts_with(tou_sv sv, tou_sv prefix);
 
-
-/* == System/IO control == */
 /**
-	@addtogroup grp_file_sysio System/IO control
-	@{
+	@brief Like ::tou_sfind_n but on views.
+
+	@param[in] str View to search in
+	@param[in] kwd Keyword to search for
+	@return Pointer to the beginning of the keyword in `str` or NULL
 */
+const char* tou_sfind_sv(tou_sv str, tou_sv kwd);
 
 /**
-	@brief Redirects STDOUT to `/dev/null` (or `NUL:` on Windows)
+	@brief Like ::tou_sfind_ci_n but on views.
 
-	Return value should be saved if you wish to
-	restore STDOUT function.
+	@param[in] str View to search in
+	@param[in] kwd Keyword to search for
+	@return Pointer to the beginning of the keyword in `str` or NULL
+*/
+const char* tou_sfind_ci_sv(tou_sv str, tou_sv kwd);
 
-	@return New file descriptor for the saved STDOUT
+/**
+	@brief Shrinks the view so it doesn't start or end with whitespace.
+
+	@param[in] sv View to trim
+	@return Trimmed view
 */
-int tou_disable_stdout();
+tou_sv tou_trim_sv(tou_sv sv);
 
 /**
-	@brief Re-enables STDOUT that had been disabled using
-	the saved file descriptor from previous function.
+	@brief Shrinks the view so it doesn't start with whitespace.
 
-	@param[in] saved_fd Saved STDOUT fd
+	@param[in] sv View to trim
+	@return Trimmed view
 */
-void tou_enable_stdout(int saved_fd);
+tou_sv tou_trim_front_sv(tou_sv sv);
 
 /**
-	@brief Shorthand for surrounding a piece of code with ::tou_disable_stdout and ::tou_enable_stdout
+	@brief Shrinks the view so it doesn't end with whitespace.
+
+	@param[in] sv View to trim
+	@return Trimmed view
 */
-#ifndef TOU_SILENCE
-#define TOU_SILENCE( ... ) \
-	_tou_g_saved_stdout = tou_disable_stdout(); \
-	__VA_ARGS__ ; \
-	tou_enable_stdout(_tou_g_saved_stdout);
-#endif
+tou_sv tou_trim_back_sv(tou_sv sv);
 
 /**
-	Filedescriptor handle local to this compilation unit used with ::TOU_SILENCE.
-	Since it isn't surrounded by `#ifdef TOU_IMPLEMENTATION` it'll be declared each time you \#include the header.
+	@brief Like ::tou_split but on views; the source is never written to.
+
+	@param[in] str View to split
+	@param[in] delim Delimiter to split on
+	@return Linked list of newly allocated tokens
 */
-static int _tou_g_saved_stdout;
+tou_llist_t* tou_split_sv(tou_sv str, tou_sv delim);
+
+/**
+	@brief Output list of views filled by ::tou_split_views.
 
+	Used the same way as ::tou_match_list: either point `items` to your own
+	array of `cap` elements, or zero it and set `growable` to have `items`
+	(re)allocated as needed (free it yourself afterwards).
+*/
+typedef struct {
+	tou_sv* items; /**< view array                                   */
+	size_t count;  /**< views stored in `items`                      */
+	size_t cap;    /**< capacity of `items`                          */
+	char growable; /**< may `items` be realloc()'d to fit everything */
+} tou_sv_list;
 
-/** @} */
+/**
+	@brief Like ::tou_split but stores views into `str` instead of copies.
 
+	Tokens are the same ones ::tou_split returns, but nothing is allocated
+	per token: `out` receives one ::tou_sv per token pointing into `str`.
+	As with ::tou_sfind_all, a fixed-size list that is too small keeps the
+	first `out->cap` tokens and the return value is still the total count.
 
-/** @} */
+	If `terminate` is set, '\0' is written over the first byte of every
+	delimiter so each token is also a C string; `str[len]` is set to '\0'
+	as well for the last one, so `str` must be writable and have room for it.
 
+	@param[in,out] str String to split (written to only if `terminate` is set)
+	@param[in] len Length of `str`, 0 to use strlen
+	@param[in] delim Delimiter string
+	@param[out] out Where to store the views, may be NULL to only count
+	@param[in] terminate Whether to NUL-terminate the tokens in place
+	@return Total number of tokens
+*/
+size_t tou_split_views(char* str, size_t len, const char* delim, tou_sv_list* out, int terminate);
 
-/* == Linked list == */
 /**
-	@addtogroup grp_llist Linked list
-	@{
+	@brief State for splitting a string lazily, one token at a time.
+
+	Nothing is allocated and the source is never written to; tokens are
+	found only when asked for, so iteration can stop after the first few.
+
+	```c
+	tou_split_iter it;
+	const char* tok;
+	size_t tok_len;
+	tou_split_iter_init(&it, line, 0, ",");
+	while (tou_split_iter_next(&it, &tok, &tok_len))
+		printf("[%.*s]\n", (int)tok_len, tok);
+	```
 */
+typedef struct {
+	const char* str;   /**< string being split                  */
+	size_t len;        /**< length of `str`                     */
+	const char* delim; /**< delimiter                           */
+	size_t delim_len;  /**< length of `delim`                   */
+	size_t pos;        /**< start of the next token in `str`    */
+} tou_split_iter;
 
 /**
-	@cond
-*/
-/** 
-	@brief Address of `dat1` or `dat2` parameter of object.
-	
-	Used when not a simple address of dat1/dat2 where you have tou_llist_t* is required, but rather when
-	you get list as double ptr and you want changes you make to the inner pointer reflect in
-	the original place instead of just locally. This construct is used multiple times when dealing
-	with .INI parser and I got tired of typing it and decided to extract it here.
-	
-	Example: when `section` is a simple pointer you would use:
-	
-		tou_llist_t* list = &(section->dat2); // parentheses for clarity
-	
-	however, if you wanted to reflect changes in the `section` ptr you would have to have `section` as a pointer-to-pointer and:
-	
-		tou_llist_t** list = &((*section)->dat2);
-	
-	which is exactly what this macro does, just professionally cluttered.
+	@brief Prepares `it` for splitting `str`.
+
+	@param[out] it Iterator state
+	@param[in] str String to split, must outlive `it`
+	@param[in] len Length of `str`, 0 to use strlen
+	@param[in] delim Delimiter string, must outlive `it`
 */
-#ifndef TOU_LLIST_DAT_ADDR
-#define TOU_LLIST_DAT_ADDR(list, param) ((tou_llist_t**)(&((*(list))->param)))
-#endif
+void tou_split_iter_init(tou_split_iter* it, const char* str, size_t len, const char* delim);
+
 /**
-	@endcond
-*/
+	@brief Finds the next token; the tokens are the same as with ::tou_split.
 
-/** 
-	@brief Creates/initializes new llist.
-	
-	Define creation of a new llist through \#define so even though it
-	currently doesn't require anything more than =NULL it will be
-	easier to extend in the future if a need for such initializer arises.
+	@param[in,out] it Iterator state
+	@param[out] tok Receives a pointer to the token in the source (not NUL-terminated)
+	@param[out] tok_len Receives the length of the token
+	@return 1 if a token was found, 0 at the end
 */
-#ifndef tou_llist_new
-#define tou_llist_new(...) ((TOU_DBG ? (fprintf(stdout,TOU_DEBUG_PREFIX"Creating new llist :: NULL\n"), (void)0) : (void)0) , NULL)
-#endif
-
-/* */
-// typedef tou_llist_t* tou_llist_elem;
-/* */
-// #define TOU_LLIST_UNPACK(elem) (*(elem))->dat1,(*(elem))->dat2
+int tou_split_iter_next(tou_split_iter* it, const char** tok, size_t* tok_len);
 
 /**
-	@brief Appends a brand new element to the list/given element and updates it in place.
-	
-	Additionally, returns a pointer to the newly created element.
+	@brief Like ::tou_sreplace_n but on views.
 
-	@param[in,out] elem Address of the element (tou_llist_t**)
-	@param[in] dat1 Data 1
-	@param[in] dat2 Data 2
-	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
-	@param[in] dat2_is_dynalloc Should dat2 be free()'d when destroying list?
-	@return Pointer to the newly created element
+	The source is never written to, so it may live in read-only memory.
+
+	@param[in] str View to replace in
+	@param[in] repl Keyword to replace
+	@param[in] with What to replace it with
+	@param[out] len_ptr If not NULL receives the length of the result
+	@return Pointer to the newly allocated replaced string
 */
+char* tou_sreplace_sv(tou_sv str, tou_sv repl, tou_sv with, size_t* len_ptr);
 
-tou_llist_t* tou_llist_append
-(
-	tou_llist_t** elem,
-	void* dat1,
-#ifndef TOU_LLIST_SINGLE_ELEM
-	void* dat2,
-#endif
-	char dat1_is_dynalloc
-#ifndef TOU_LLIST_SINGLE_ELEM
-	, char dat2_is_dynalloc
-#endif
-);
+/**
+	@brief Growable string builder.
+
+	Tracks its length and capacity and grows geometrically, so appending
+	one character or token at a time is amortized O(1) instead of the
+	strlen+realloc done by ::tou_sappend on every call.
+
+	Zero-initialize it (or use ::tou_sbuf_init) before use. `data` is always
+	NUL-terminated once anything was appended or reserved.
+	```c
+	tou_sbuf sb = {0};
+	tou_sbuf_append(&sb, "total: ");
+	tou_sbuf_appendf(&sb, "%d items", n);
+	char* str = tou_sbuf_detach(&sb); // plain malloc'd char*, free() when done
+	```
+*/
+typedef struct tou_sbuf {
+	char* data;  /**< contents, NUL-terminated    */
+	size_t len;  /**< length without the NUL      */
+	size_t cap;  /**< allocated bytes (incl. NUL) */
+} tou_sbuf;
 
 /**
-	@brief Appends a brand new element to the list/given element which
-	contains only `dat1` and if the pointer was the head, updates it in place.
-	
-	`dat2` is set to a default of NULL and 0.
-	Additionally, returns a pointer to the newly created element.
+	@brief Initializes an empty builder (same as zeroing it).
 
-	@param[in,out] elem Address of the element (tou_llist_t**)
-	@param[in] dat1 Data 1
-	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
-	@return Pointer to the newly created element
+	@param[out] sb Builder to initialize
 */
-tou_llist_t* tou_llist_appendone(tou_llist_t** elem, void* dat1, char dat1_is_dynalloc);
+void tou_sbuf_init(tou_sbuf* sb);
 
 /**
-	@brief Prepends a brand new element to the list/given element.
-	
-	Additionally, returns a pointer to the newly created element.
+	@brief Frees the builder's memory and empties it.
 
-	@param[in,out] elem Address of the element (tou_llist_t**)
-	@param[in] dat1 Data 1
-	@param[in] dat2 Data 2
-	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
-	@param[in] dat2_is_dynalloc Should dat2 be free()'d when destroying list?
-	@return Pointer to the newly created element
+	@param[in,out] sb Builder to free
 */
+void tou_sbuf_destroy(tou_sbuf* sb);
 
-tou_llist_t* tou_llist_prepend
-(
-	tou_llist_t** elem,
-	void* dat1,
-#ifndef TOU_LLIST_SINGLE_ELEM
-	void* dat2,
-#endif
-	char dat1_is_dynalloc
-#ifndef TOU_LLIST_SINGLE_ELEM
-	, char dat2_is_dynalloc
-#endif
-);
+/**
+	@brief Makes sure at least `extra` more bytes can be appended without reallocating.
+
+	@param[in,out] sb Builder
+	@param[in] extra Count of bytes that will be appended
+	@return Zero if successful, -1 if memory couldn't be allocated
+*/
+int tou_sbuf_reserve(tou_sbuf* sb, size_t extra);
 
 /**
-	@brief Prepends a brand new element to the list/given
-	element which only contains `dat1`.
-	
-	`dat2` is set to a default of NULL and 0.
-	Additionally, returns a pointer to the newly created element.
+	@brief Appends a NUL-terminated string.
 
-	@param[in,out] elem Address of the element (tou_llist_t**)
-	@param[in] dat1 Data 1
-	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
-	@return Pointer to the newly created element
+	@param[in,out] sb Builder
+	@param[in] str String to append, may be NULL
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-tou_llist_t* tou_llist_prependone(tou_llist_t** elem, void* dat1, char dat1_is_dynalloc);
+int tou_sbuf_append(tou_sbuf* sb, const char* str);
 
 /**
-	@brief Traverses elements using .next or .prev and frees each one
-	including copied category string
+	@brief Appends `n` bytes of `str` (which needs no terminator).
 
-	@param[in] list Either head or tail element
+	@param[in,out] sb Builder
+	@param[in] str Bytes to append
+	@param[in] n Count of bytes to append
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-void tou_llist_destroy(tou_llist_t* list);
+int tou_sbuf_appendn(tou_sbuf* sb, const char* str, size_t n);
 
 /**
-	@brief Removes an element from llist and deallocates it
+	@brief Appends a single character.
 
-	If you were to for example remove the head you should assign
-	the return value to something or else you will be left with
-	an invalid pointer and a segfault because this function simply
-	reconnects .prev and .next if they exist, and frees the element.
-	
-	If `elem` was the head, function will return .prev to be used as
-	the new head. Otherwise, it will return .next which may be used
-	or ignored.
+	@param[in,out] sb Builder
+	@param[in] ch Character to append
+	@return Zero if successful, -1 if memory couldn't be allocated
+*/
+int tou_sbuf_appendch(tou_sbuf* sb, char ch);
 
-	@param[in] elem Pointer to the element to be removed
-	@return Element that should optionally take `elem`'s place
+/**
+	@brief Appends printf-style formatted text, written straight into the spare capacity.
+
+	@param[in,out] sb Builder
+	@param[in] format printf() format string
+	@return Zero if successful, -1 on allocation or format error
 */
-tou_llist_t* tou_llist_remove(tou_llist_t* elem);
+int tou_sbuf_appendf(tou_sbuf* sb, const char* format, ...);
 
 /**
-	@brief Disconnects an element from llist but does not deallocate it.
-	You should destroy it by calling ::tou_llist_free_element or manually.
-	
-	@param[in] elem Pointer to the element to be removed
-	@return Pointer to the element popped from llist
+	@brief Empties the builder but keeps its memory for reuse.
+
+	@param[in,out] sb Builder
 */
-tou_llist_t* tou_llist_pop(tou_llist_t* elem);
+void tou_sbuf_clear(tou_sbuf* sb);
 
 /**
-	@brief Frees an element and its contents.
+	@brief Hands the contents over as a plain malloc'd string and empties the builder.
 
-	Do NOT use on an element still associated with list;
-	use only on a ::tou_llist_pop'd elem for example.
+	The result is shrunk to fit and can be used with the rest of the
+	string functions (::tou_sappend, ::tou_sreplace etc.) and free().
 
-	@param[in] elem Pointer to the element to be freed
+	@param[in,out] sb Builder
+	@return Pointer to the string (an empty one if nothing was appended), or NULL on error
 */
-void tou_llist_free_element(tou_llist_t* elem);
+char* tou_sbuf_detach(tou_sbuf* sb);
 
 /**
-	@brief Traverses the whole list using `.next` and returns the last element
-	that was added into list (where `.next` is NULL)
+	@brief Double-ended string buffer with free room at both ends.
 
-	@param[in] list Element of type tou_llist_t*
-	@return Pointer to the head element
+	Prepending and appending are both amortized O(1): data is moved only
+	when the side being written to runs out of room, and then it's
+	re-centered (or moved to a twice larger buffer) so both ends get
+	free room again.
+
+	Zero-initialize it (or use ::tou_dbuf_init) before use.
+	```c
+	tou_dbuf path = {0};
+	tou_dbuf_append(&path, "file.txt");
+	tou_dbuf_prepend(&path, "dir/");
+	tou_dbuf_prependch(&path, '/');
+	printf("%s\n", tou_dbuf_str(&path)); // "/dir/file.txt"
+	tou_dbuf_destroy(&path);
+	```
 */
-tou_llist_t* tou_llist_get_head(tou_llist_t* list);
+typedef struct tou_dbuf {
+	char* mem;    /**< allocated memory                          */
+	size_t start; /**< offset of the contents (free room in front) */
+	size_t len;   /**< length of the contents without the NUL    */
+	size_t cap;   /**< allocated bytes                           */
+} tou_dbuf;
 
 /**
-	@brief Traverses the whole list using `.prev` and returns the first element
-	that was added to list (where `.prev` is NULL)
+	@brief Initializes an empty buffer (same as zeroing it).
 
-	@param[in] list Element of type ::tou_llist_t*
-	@return Pointer to the tail element
+	@param[out] db Buffer to initialize
 */
-tou_llist_t* tou_llist_get_tail(tou_llist_t* list);
+void tou_dbuf_init(tou_dbuf* db);
 
 /**
-	@brief Returns the element that was added to the list last.
-	
-	Alias for ::tou_llist_get_head.
+	@brief Frees the buffer's memory and empties it.
 
-	@param[in] list Element of type ::tou_llist_t*
-	@return Pointer to the newest element
+	@param[in,out] db Buffer to free
 */
-tou_llist_t* tou_llist_get_newest(tou_llist_t* list);
+void tou_dbuf_destroy(tou_dbuf* db);
 
 /**
-	@brief Returns the element that was added to the list first.
-	
-	Alias for ::tou_llist_get_tail.
+	@brief Makes sure `front` bytes can be prepended and `back` bytes
+	appended without moving the contents.
 
-	@param[in] list Element of type ::tou_llist_t*
-	@return Pointer to the oldest element
+	@param[in,out] db Buffer
+	@param[in] front Count of bytes that will be prepended
+	@param[in] back Count of bytes that will be appended
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-tou_llist_t* tou_llist_get_oldest(tou_llist_t* list);
+int tou_dbuf_reserve(tou_dbuf* db, size_t front, size_t back);
 
 /**
-	@brief Returns the element added after `elem`.
+	@brief Returns the contents as a NUL-terminated string ("" if empty).
 
-	Returns `.next` of the `elem`.
+	The pointer is valid until the buffer is modified.
 
-	@param[in] elem Element of type ::tou_llist_t*
-	@return Pointer to the requested element
+	@param[in] db Buffer
+	@return Pointer to the contents
 */
-tou_llist_t* tou_llist_get_newer(tou_llist_t* elem);
+const char* tou_dbuf_str(const tou_dbuf* db);
 
 /**
-	@brief Returns the element added before `elem`.
-
-	Returns `.prev` of the `elem`.
+	@brief Appends `n` bytes of `str`.
 
-	@param[in] elem Element of type ::tou_llist_t*
-	@return Pointer to the requested element
+	@param[in,out] db Buffer
+	@param[in] str Bytes to append
+	@param[in] n Count of bytes
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-tou_llist_t* tou_llist_get_older(tou_llist_t* elem);
+int tou_dbuf_appendn(tou_dbuf* db, const char* str, size_t n);
 
 /**
-	@brief Updates `elem` to point to the element added after itself.
+	@brief Appends a NUL-terminated string.
 
-	`elem` is updated to `.next` of the `elem`.
-	That same `.next` is additionally returned from function.
-
-	@param[in,out] elem Address of the element
-	@return Pointer to the element
+	@param[in,out] db Buffer
+	@param[in] str String to append, may be NULL
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-tou_llist_t* tou_llist_next_newer(tou_llist_t** elem);
+int tou_dbuf_append(tou_dbuf* db, const char* str);
 
 /**
-	@brief Updates `elem` to point to the element added before itself.
-
-	`elem` is updated to `.prev` of the `elem`.
-	That same `.next` is additionally returned from function.
+	@brief Appends a single character.
 
-	@param[in,out] elem Address of the element
-	@return Pointer to the element
+	@param[in,out] db Buffer
+	@param[in] ch Character to append
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-tou_llist_t* tou_llist_next_older(tou_llist_t** elem);
+int tou_dbuf_appendch(tou_dbuf* db, char ch);
 
 /**
-	@brief Checks if element is head of the list
-	(`.next` should be NULL)
+	@brief Prepends `n` bytes of `str`.
 
-	@param[in] elem Element to check
-	@return 1 or 0 depending on result
+	@param[in,out] db Buffer
+	@param[in] str Bytes to prepend
+	@param[in] n Count of bytes
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-char tou_llist_is_head(tou_llist_t* elem);
+int tou_dbuf_prependn(tou_dbuf* db, const char* str, size_t n);
 
 /**
-	@brief Checks if element is tail of the list
-	(`.prev` should be NULL)
+	@brief Prepends a NUL-terminated string.
 
-	@param[in] elem Element to check
-	@return 1 or 0 depending on result
+	@param[in,out] db Buffer
+	@param[in] str String to prepend, may be NULL
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-char tou_llist_is_tail(tou_llist_t* elem);
+int tou_dbuf_prepend(tou_dbuf* db, const char* str);
 
 /**
-	@brief Iterate through and call the specified function for each element
-	Automatically checks whether given element is head or tail and 
-	iterates accordingly.
-	If given function returns a 0 the iteration terminates early.
+	@brief Prepends a single character.
 
-	@param[in] list Head or tail of the list
-	@param[in] cb Function to be called for each element
+	@param[in,out] db Buffer
+	@param[in] ch Character to prepend
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-void tou_llist_iter(tou_llist_t* list, tou_func cb);
+int tou_dbuf_prependch(tou_dbuf* db, char ch);
 
 /**
-	@brief Traverses the list starting from the passed element and tries
-	to find the first matching element by simple equals-comparison
-	using both parameters at the same time.
+	@brief Hands the contents over as a plain malloc'd string and empties the buffer.
 
-	@param[in] list Element to start the search from
-	@param[in] dat1 Comparison value
-	@param[in] dat2 Comparison value (if enabled)
-	@return Found element or NULL
+	@param[in,out] db Buffer
+	@return Pointer to the string (an empty one if nothing was added), or NULL on error
 */
-tou_llist_t* tou_llist_find_exact
-(
-	tou_llist_t* list,
-	void* dat1
-#ifndef TOU_LLIST_SINGLE_ELEM
-	, void* dat2
-#endif
-);
+char* tou_dbuf_detach(tou_dbuf* db);
 
 /**
-	@brief Traverses the list starting from the passed element and tries
-	to find the first matching element by simple equals-comparison of param.
+	@brief Quote-aware CSV/TSV reader producing rows of field views.
 
-	@param[in] list Element to start the search from
-	@param[in] dat1 Comparison value
-	@return Found element or NULL
+	Fields are separated by `delim` and rows by '\n' (a '\r' before it is
+	dropped). A field starting with `quote` may contain delimiters, newlines
+	and doubled quotes, which stand for one quote. Quotes and separators are
+	classified 64 bytes at a time with vector compares, and fields are
+	handed out as ::tou_sv views, without allocating anything per field.
+	Fields are views into the input, except fields with doubled quotes which
+	point to an internal buffer; all of them stay valid until the next row.
+
+	Rows can be pulled out of a whole buffer (ex. a mapped file):
+	```c
+	tou_csv csv;
+	tou_csv_init(&csv, ',', NULL, NULL);
+	tou_csv_set_buffer(&csv, data, len);
+	while (tou_csv_next_row(&csv))
+		printf("%zu fields, first: %.*s\n", csv.n_fields, (int)csv.fields[0].n, csv.fields[0].p);
+	tou_csv_destroy(&csv);
+	```
+	or pushed through a callback while reading a stream in blocks:
+	```c
+	tou_csv_init(&csv, '\t', my_row_cb, my_data);
+	tou_read_fp_in_blocks(fp, 0, tou_csv_cb, &csv);
+	tou_csv_finish(&csv);
+	tou_csv_destroy(&csv);
+	```
+	The row callback receives the following args:
+	- `fields` [in] Pointer to the first ::tou_sv of the row
+	- `n_fields` [in] (size_t) Count of fields
+	- `userdata` [in,out] User data passed at the beginning
+	and returns ::TOU_CONTINUE or ::TOU_BREAK to stop.
 */
-tou_llist_t* tou_llist_find_exactone(tou_llist_t* list, void* dat1);
+typedef struct {
+	char delim;          /**< field delimiter                                */
+	char quote;          /**< quote character, '\0' to disable quoting       */
+	tou_sv* fields;      /**< fields of the current row                      */
+	size_t n_fields;     /**< count of fields in `fields`                    */
+	size_t cap_fields;   /**< allocated size of `fields`                     */
+	size_t rows;         /**< count of rows produced so far                  */
+	tou_func3 cb;        /**< called for each row when streaming             */
+	void* userdata;      /**< passed to `cb`                                 */
+	char stopped;        /**< set once `cb` returned ::TOU_BREAK             */
+	/** @cond */
+	const char* data;    /* input being split into rows */
+	size_t len;
+	size_t pos;          /* start of the next row */
+	size_t at;           /* classification continues from here */
+	uint64_t in_quotes;  /* all ones if `at` is inside quotes */
+	size_t* offs;        /* batch of separator offsets */
+	size_t n_offs;
+	size_t i_offs;
+	char last;           /* `data` ends the input */
+	tou_sbuf unescaped;  /* fields with doubled quotes */
+	tou_sbuf carry;      /* unfinished row between blocks */
+	/** @endcond */
+} tou_csv;
 
 /**
-	@brief Traverses the list starting from the passed element and tries
-	to find the first matching element on the basis: if dat1 is not null,
-	tries to match it as a nul-terminated string
+	@brief Initializes the reader; quoting with '"' is enabled by default.
 
-	@param[in] list Element to start the search from
-	@param[in] dat1 Comparison value
-	@return Found element or NULL
+	@param[out] csv Reader to initialize
+	@param[in] delim Field delimiter, ex. ',' or '\t'
+	@param[in] cb Row callback for ::tou_csv_feed, may be NULL when using ::tou_csv_next_row
+	@param[in] userdata User data passed to callback
+	@return Zero if successful, -1 if memory couldn't be allocated
 */
-tou_llist_t* tou_llist_find_key(tou_llist_t* list, void* dat1);
+int tou_csv_init(tou_csv* csv, char delim, tou_func3 cb, void* userdata);
 
 /**
-	@brief Traverses the list starting from the passed element and tries
-	to find the first matching element by checking the return value
-	of the given callback comparison function.
-
-	If function's return value equals 0 the element is considered matched
-	and the search terminates, otherwise search continues.
+	@brief Releases memory held by the reader.
 
-	@param[in] list Element to start the search from
-	@param[in] cb Custom comparison function
-	@param[in] userdata Custom data to be given to the cb() function
-	@return Found element or NULL
+	@param[in,out] csv Reader
 */
-tou_llist_t* tou_llist_find_func(tou_llist_t* list, tou_func2 cb, void* userdata);
+void tou_csv_destroy(tou_csv* csv);
 
 /**
-	@brief Goes through the list and returns amount of elements.
+	@brief Sets the whole input to read rows from with ::tou_csv_next_row.
 
-	@param[in] list List to count elements
-	@return Number of elements
+	@param[in,out] csv Reader
+	@param[in] data Input, doesn't need to be NUL-terminated; must outlive the rows
+	@param[in] len Length of `data`
 */
-size_t tou_llist_len(tou_llist_t* list);
+void tou_csv_set_buffer(tou_csv* csv, const char* data, size_t len);
 
 /**
-	@brief Constructs a dynamically allocated ARRAY containing
-	only .dat1 properties (stored as void*).
+	@brief Reads the next row into `csv->fields` / `csv->n_fields`.
 
-	@param[in] list Linked list to construct array from
-	@param[out] len Optional length of the array/llist
-	@return Void* array of .dat1's
+	@param[in,out] csv Reader
+	@return 1 if a row was read, 0 at the end of the input
 */
-void** tou_llist_gather_dat1(tou_llist_t* list, size_t* len);
+int tou_csv_next_row(tou_csv* csv);
 
 /**
-	@brief Constructs a dynamically allocated ARRAY containing
-	only .dat2 properties (stored as void*).
+	@brief Feeds the next chunk of a stream, calling the row callback for
+	every row completed by it.
 
-	@param[in] list Linked list to construct array from
-	@param[out] len Optional length of the array/llist
-	@return Void* array of .dat2's
-*/
-#ifndef TOU_LLIST_SINGLE_ELEM
-void** tou_llist_gather_dat2(tou_llist_t* list, size_t* len);
-#endif
+	Rows are parsed in the chunk itself; only an unfinished last row is
+	copied to be completed by the next chunk.
 
-/** @brief Convenience alias for gathering first element */
-#define tou_llist_gather tou_llist_gather_dat1
+	@param[in,out] csv Reader
+	@param[in] data Chunk data (no need for NUL)
+	@param[in] len Chunk length
+	@return ::TOU_BREAK if callback stopped reading (or on error), ::TOU_CONTINUE otherwise
+*/
+int tou_csv_feed(tou_csv* csv, const char* data, size_t len);
 
 /**
-	@brief Macro that goes through the elements from head to tail and prints
-	their `.dat1` and `.dat2` fields using given format specifiers.
+	@brief Signals the end of the stream; hands over the last row if it
+	wasn't terminated by a newline.
 
-	If TOU_LLIST_SINGLE_ELEM is defined it will accept only `dat1_spec`
-	and print only `.dat1` (`dat2_spec` will be ignored if specified).
+	@param[in,out] csv Reader
+*/
+void tou_csv_finish(tou_csv* csv);
 
-	It is not enough if for example your wish is to print the value
-	of `int*`, but if you just want that pointer, string or if you
-	stored value itself into the field it will come in handy.
+/**
+	@brief Block callback for ::tou_read_fp_in_blocks which feeds each block
+	to the ::tou_csv passed as `userdata`.
 
-	@param[in] llist List to print
-	@param[in] dat1_spec Format specifier for `.dat1`
-	@param[in] dat2_spec Format specifier for `.dat2`
+	@param[in] blockdata Pointer to the beginning of new data
+	@param[in] len Amount of bytes actually read
+	@param[in] userdata Pointer to ::tou_csv
+	@return Whether to continue with read iterations (::tou_iter_action)
 */
-#ifndef tou_llist_print
-#ifndef TOU_LLIST_SINGLE_ELEM
+void* tou_csv_cb(void* blockdata, void* len, void* userdata);
 
-	#define tou_llist_print(llist, dat1_spec, dat2_spec, ...)                          \
-	{                                                                                  \
-		tou_llist_t* copy = tou_llist_get_newest(llist);                               \
-		printf("List contents: (%d)\n", tou_llist_len(copy));                          \
-		while (copy) {                                                                 \
-			printf("  |\n  " dat1_spec " :: " dat2_spec "\n", copy->dat1, copy->dat2); \
-			copy = tou_llist_get_older(copy);                                          \
-		}                                                                              \
-	} (void)0
 
-#else
+/** @} */
 
-	#define tou_llist_print(llist, dat1_spec, ...)            \
-	{                                                         \
-		tou_llist_t* copy = tou_llist_get_newest(llist);      \
-		printf("List contents: (%d)\n", tou_llist_len(copy)); \
-		while (copy) {                                        \
-			printf("  |\n  " dat1_spec "\n", copy->dat1);     \
-			copy = tou_llist_get_older(copy);                 \
-		}                                                     \
-	} (void)0
 
-#endif
-#endif
+/* == File operations == */
+/**
+	@addtogroup grp_file File operations
+	@{
+*/
 
 /**
-	@brief Macro that goes through the elements from tail to head and prints
-	their `.dat1` and `.dat2` fields using given format specifiers.
+	@brief Reads file in blocks, calling user-provided function for each block.
 
-	If TOU_LLIST_SINGLE_ELEM is defined it will accept only `dat1_spec`
-	and print only `.dat1` (`dat2_spec` will be ignored if specified).
+	Automatically allocates memory and returns amount read.
+	Function receives 3 parameters:
+	- `data` [in] Pointer to new data
+	- `len` [in] Amount of bytes actually read
+	- `userdata` [in,out] User data provided
 
-	It is not enough if for example your wish is to print the value
-	of `int*`, but if you just want that pointer, string or if you
-	stored value itself into the field it will come in handy.
+	Look into this function's source and/or ::tou_block_store_cb and
+	::tou_block_store_struct for more info about using it.
 
-	@param[in] llist List to print
-	@param[in] dat1_spec Format specifier for `.dat1`
-	@param[in] dat2_spec Format specifier for `.dat2`
-*/
-#ifndef tou_llist_print_tail
-#ifndef TOU_LLIST_SINGLE_ELEM
+	The block is read into heap memory through a ::tou_block_reader and
+	is not cleared between reads, so only the first `len` bytes are valid.
 
-	#define tou_llist_print_tail(llist, dat1_spec, dat2_spec, ...)                 \
-	{                                                                              \
-		tou_llist_t* copy = tou_llist_get_oldest(llist);                           \
-		printf("List contents: (%d)\n", tou_llist_len(copy));                      \
-		while (copy) {                                                             \
-			printf("  |\n  "dat1_spec" :: "dat2_spec"\n", copy->dat1, copy->dat2); \
-			copy = tou_llist_get_newer(copy);                                      \
-		}                                                                          \
-	} (void)0
+	@param[in] fp FILE* from which data is to be read
+	@param[in] blocksize Size in bytes; set to 0 or (size_t)-1 to use default (::TOU_DEFAULT_BLOCKSIZE)
+	@param[in] cb Function to call for each block
+	@param[in] userdata Custom data to be passed to function
+	@return Total bytes read (0 if a block of `blocksize` bytes can't be allocated)
+*/
+size_t tou_read_fp_in_blocks(FILE* fp, size_t blocksize, tou_func3 cb, void* userdata);
 
-#else
+/**
+	@brief Like ::tou_read_fp_in_blocks, but reads ahead on a background thread.
 
-	#define tou_llist_print_tail(llist, dat1_spec, ...)       \
-	{                                                         \
-		tou_llist_t* copy = tou_llist_get_oldest(llist);      \
-		printf("List contents: (%d)\n", tou_llist_len(copy)); \
-		while (copy) {                                        \
-			printf("  |\n  "dat1_spec"\n", copy->dat1);       \
-			copy = tou_llist_get_newer(copy);                 \
-		}                                                     \
-	} (void)0
+	While `cb` works on one block, the following ones are already being
+	read into a ring of `nbuffers` buffers, so I/O and processing overlap.
+	Blocks still arrive in order, on the calling thread, and returning
+	::TOU_BREAK stops the reading as well (although `fp` may have been
+	read up to `nbuffers - 1` blocks further than what was delivered).
 
-#endif
-#endif
+	Falls back to ::tou_read_fp_in_blocks with `TOU_NO_THREADS` or if
+	the thread can't be started.
 
+	@param[in] fp FILE* from which data is to be read
+	@param[in] blocksize Size in bytes; set to 0 or (size_t)-1 to use default (::TOU_DEFAULT_BLOCKSIZE)
+	@param[in] nbuffers Number of blocks in flight; 0 means 2 (double buffering)
+	@param[in] cb Function to call for each block
+	@param[in] userdata Custom data to be passed to function
+	@return Total bytes delivered to `cb`
+*/
+size_t tou_read_fp_in_blocks_ahead(FILE* fp, size_t blocksize, int nbuffers, tou_func3 cb, void* userdata);
 
-/** @} */
+/**
+	@brief Reads `fp` in blocks and processes them on `nthreads` worker threads, in order.
+
+	Every block is passed to `map_cb` on one of the workers, several
+	blocks at a time, while the calling thread keeps reading. What
+	`map_cb` returns is then passed to `reduce_cb` on the calling thread
+	strictly in file order:
+	- `map_cb(blockdata, len, userdata)` returns a result for the block
+	  (ex. a checksum, a count or a malloc'd list of tokens)
+	- `reduce_cb(result, index, userdata)` gets that result and the
+	  block's index (first is 0) and returns ::TOU_CONTINUE or ::TOU_BREAK
+
+	`map_cb` must only touch `userdata` in a thread-safe way; `reduce_cb`
+	calls never overlap. Up to `2 * nthreads + 1` blocks are in flight at
+	once, each in its own buffer. After ::TOU_BREAK the blocks that were
+	already mapped but not reduced yet are dropped along with their
+	results, so results needing cleanup should be tracked in `userdata`.
+
+	With `TOU_NO_THREADS`, `nthreads == 1` or if no thread can be
+	started, everything runs on the calling thread.
+
+	@code{.c}
+	void* map_crc(void* data, void* len, void* ud) { return (void*)(uintptr_t)crc32(data, (size_t)len); }
+	void* reduce_crc(void* crc, void* idx, void* ud) { combine((uint32_t*)ud, (uint32_t)(uintptr_t)crc); return (void*)TOU_CONTINUE; }
+
+	uint32_t total = 0;
+	tou_read_fp_in_blocks_parallel(fp, 1 << 20, map_crc, reduce_crc, &total, 0);
+	@endcode
 
+	@param[in] fp FILE* from which data is to be read
+	@param[in] blocksize Size in bytes; set to 0 or (size_t)-1 to use default (::TOU_DEFAULT_BLOCKSIZE)
+	@param[in] map_cb Function called for each block on a worker (may be NULL)
+	@param[in] reduce_cb Function called with each result in order on the calling thread (may be NULL)
+	@param[in] userdata Custom data to be passed to both functions
+	@param[in] nthreads Number of workers; 0 or less means one per CPU
+	@return Total bytes of the blocks passed to `reduce_cb`
+*/
+size_t tou_read_fp_in_blocks_parallel(FILE* fp, size_t blocksize, tou_func3 map_cb, tou_func3 reduce_cb, void* userdata, int nthreads);
 
-/* == Stack == */
 /**
-	@addtogroup grp_stack Stack
+	@addtogroup grp_file_lower Lower file operations
 	@{
 */
 
-/** @brief Make a stack alias for convenience */
-typedef tou_llist_t tou_stack;
-
 /**
-	@brief Creates a new stack object
+	@brief Struct containing buffer and count to be used in block-reading
 
-	@return Stack object
+	This struct is automatically instantiated by ::tou_read_file and passed to
+	::tou_read_fp_in_blocks, but may also be used manually for any purpose.
 */
-tou_llist_t* tou_stack_new();
+typedef struct {
+	char* buffer; /**< Buffer to append data to */
+	size_t size; /**< Length of the buffer contents */
+	size_t capacity; /**< Allocated size of the buffer (may be left 0) */
+} tou_block_store_struct;
 
 /**
-	@brief Destroys existing stack object
+	@brief Appends the given block to the buffer in
+	`tou_block_store_struct` through realloc().
 
-	@param[in] stack Object to destroy
+	Memory for '\0' at the end will be allocated, but will not be
+	indicated in `.size` parameter. The buffer grows geometrically, so
+	appending is amortized O(1) per byte. May also be used manually
+	for any purpose, with ::tou_read_fp_in_blocks or elsewhere.
+
+	@param[in] blockdata Pointer to the beginning of new data
+	@param[in] len Amount of bytes actually read
+	@param[in] userdata User data provided
+	@return Whether to continue with read iterations (::tou_iter_action)
 */
-void tou_stack_destroy(tou_llist_t* stack);
+void* tou_block_store_cb(void* blockdata, void* len, void* userdata);
 
 /**
-	@brief Returns the length of the stack
-
-	@param[in] stack Stack object
-	@return Stack length
+	@brief Alignment of block buffers allocated by ::tou_block_reader_init
 */
-size_t tou_stack_len(tou_llist_t* stack);
+#ifndef TOU_BLOCK_ALIGN
+#define TOU_BLOCK_ALIGN 4096
+#endif
 
 /**
-	@brief Pushes a new element to the top of the stack
-
-	@param[in] stack Stack object
-	@param[in] elem Element to push 
+	@brief Reusable block reader with a heap buffer.
+
+	Reads fixed-size blocks into one buffer that is kept between reads
+	and between sources, so large (multiple MiB) blocks are fine even on
+	small thread stacks. Every block is full except for the last one.
+
+	Reads either from a `FILE*` (through fread(), which passes reads of
+	a block this large straight to the OS) or from a file descriptor
+	with read(), or with pread() at `offset` so several readers may
+	share one descriptor.
+
+	@code{.c}
+	tou_block_reader r;
+	tou_block_reader_init(&r, 4 << 20, NULL);
+	tou_block_reader_set_fp(&r, fp);
+	size_t n;
+	while ((n = tou_block_reader_read(&r)) > 0)
+		process(r.buffer, n);
+	tou_block_reader_destroy(&r);
+	@endcode
 */
-void tou_stack_push(tou_llist_t** stack, void* elem);
+typedef struct {
+	char* buffer; /**< Block buffer */
+	size_t blocksize; /**< Size of `buffer` */
+	size_t len; /**< Bytes read into `buffer` by the last read */
+	unsigned long long offset; /**< Offset of the next block from where reading started (file offset when positional) */
+	FILE* fp; /**< Source stream, or NULL when reading `fd` */
+	int fd; /**< Source descriptor, or -1 */
+	char positional; /**< Whether `fd` is read with pread() at `offset` */
+	char error; /**< Set when a read failed */
+	void* mem; /**< Allocation behind `buffer` when owned by the reader */
+} tou_block_reader;
 
 /**
-	@brief Pops an element from the top of the stack
+	@brief Initializes a block reader.
 
-	@param[in] stack Pointer to the stack object
-	@return Element
+	@param[out] reader Reader to initialize
+	@param[in] blocksize Size in bytes; set to 0 or (size_t)-1 to use default (::TOU_DEFAULT_BLOCKSIZE)
+	@param[in] buffer Caller-supplied buffer of at least `blocksize` bytes,
+		or NULL to allocate one aligned to ::TOU_BLOCK_ALIGN
+	@return 0 on success, -1 if allocation failed
 */
-void* tou_stack_pop(tou_llist_t** stack);
-
+int tou_block_reader_init(tou_block_reader* reader, size_t blocksize, char* buffer);
 
-/** @} */
+/**
+	@brief Frees the reader's buffer if it allocated it.
 
+	Doesn't close the source.
 
-/* == Queue == */
-/**
-	@addtogroup grp_queue Queue
-	@{
+	@param[in,out] reader Reader to destroy
 */
-
-/** @brief Make a queue alias for convenience */
-typedef tou_llist_t tou_queue;
+void tou_block_reader_destroy(tou_block_reader* reader);
 
 /**
-	@brief Creates a new queue object
+	@brief Makes the reader read blocks from `fp`.
 
-	@return Queue object
+	@param[in,out] reader Reader
+	@param[in] fp Stream to read from its current position
 */
-tou_llist_t* tou_queue_new();
+void tou_block_reader_set_fp(tou_block_reader* reader, FILE* fp);
 
 /**
-	@brief Destroys existing queue object
+	@brief Makes the reader read blocks from the file descriptor `fd`.
 
-	@param[in] queue Object to destroy
-*/
-void tou_queue_destroy(tou_llist_t* queue);
+	With `positional` set, blocks are read with pread() starting at
+	`offset` and the descriptor's own position is left alone, so other
+	threads may read the same descriptor at the same time. Without it
+	blocks are read with read() from the current position and `offset`
+	is only counted from 0.
 
-/**
-	@brief Returns the length of the queue
+	Not available on Windows. Strict ISO modes need `_DEFAULT_SOURCE` for pread().
 
-	@param[in] queue Queue object
-	@return Queue length
+	@param[in,out] reader Reader
+	@param[in] fd Descriptor to read from
+	@param[in] positional Whether to read with pread() at `offset`
+	@param[in] offset File offset of the first block when `positional`
 */
-size_t tou_queue_len(tou_llist_t* queue);
+#ifndef _WIN32
+void tou_block_reader_set_fd(tou_block_reader* reader, int fd, int positional, unsigned long long offset);
+#endif
 
 /**
-	@brief Pushes a new element to the top of the Queue
-
-	@param[in] queue Queue object
-	@param[in] elem Element to push 
-*/
-void tou_queue_push(tou_llist_t** queue, void* elem);
+	@brief Reads the next block into `reader->buffer`.
 
-/**
-	@brief Pops an element from the top of the Queue
+	Keeps reading until the block is full or the input ends.
 
-	@param[in] queue Pointer to the queue object
-	@return Element
+	@param[in,out] reader Reader
+	@return Bytes read (also stored in `len`), 0 at the end or on error (see `error`)
 */
-void* tou_queue_pop(tou_llist_t** queue);
-
-
-/** @} */
+size_t tou_block_reader_read(tou_block_reader* reader);
 
-
-/* == INI parser == */
 /**
-	@addtogroup grp_ini INI operations
-	Loading, saving and working with .ini files.
+	@brief Reads all remaining blocks, calling `cb` for each.
 
-	Loaded data is internally structured as a linked list (::tou_llist_t)
-	of INI sections with first parameter being the section name and second
-	being a sub-linked-list containing its properties where first and
-	second property represent the property's key and value respectively.
-	You may get a relatively similar visual by calling ::tou_ini_print.
-	```
-	<SECTION> -(first)-> "section 1"
-	 :     |
-	 :  (second)
-	 :     |
-	 :     +-> <PROPERTY> -(first)-> "persons name"
-	 :     :        |
-	 :     :     (second)
-  	 :     :        |
-	 :     :        +-> "John"
-	 :     :
-	 :     +-> <PROPERTY> -> "persons age"
-	 :             |     
-     :             +-> "654"
-	 :
-	<SECTION> -> "section 2"
-	 :     |
-	 :     +-> <PROPERTY> -> "Text contents"
-	 :     :        |
-	 :     .        +-> "Lorem ipsum dolor sit amet,    and  even  more  text ...     "
-     .       
-	```
+	`cb` gets the same parameters and may return ::TOU_BREAK just like
+	with ::tou_read_fp_in_blocks.
 
-	@{
+	@param[in,out] reader Reader
+	@param[in] cb Function to call for each block
+	@param[in] userdata Custom data to be passed to function
+	@return Total bytes read
 */
-
-#ifdef TOU_LLIST_SINGLE_ELEM
-#warning TOU_LLIST_SINGLE_ELEM DEFINED, TOU_INI DISABLED.
-#else
-
+size_t tou_block_reader_run(tou_block_reader* reader, tou_func3 cb, void* userdata);
 
 /**
-	@brief Parses given FILE* as .INI file and constructs structured data.
-
-	Parser supports using semicolon (;) and hashtag (#) for comments,
-	however they must be on a separate line by themselves.
-	Specifying the same section name more than once is not supported (that
-	may change in the future where the definitions would merge and "flatten"
-	into one combined section).
-	
-	Whitespaces may be added between sections, properties and section name
-	brackets for better readability. When specifying properties both keys
-	and values may have *some* whitespaces in them.
-	However, all whitespaces at the beginning and the end of the *key* will be
-	removed, as well as all whitespaces at the end of the *value*. If the value
-	starts with a whitespace, only that single whitespace will be removed.
-	Keep in mind that keys having whitespaces inside of them will be sensitive
-	to them when reading the data.
+	@brief Like ::tou_block_reader_run, but reads ahead on a background thread.
 
-	Structured data is constructed as two layers of llists where the primary list
-	that gets returned from function represents sections in .INI file where the
-	section names and properties are stored in .dat1 and .dat2 fields respectively.
-	Properties in .dat2 are stored as sub-llist where keys and values are allocated
-	and are stored as strings in .dat1 and .dat2 fields respectively.
+	Reading goes on in a ring of `nbuffers` blocks (the reader's buffer
+	plus `nbuffers - 1` allocated ones) while `cb` processes the oldest
+	one; see ::tou_read_fp_in_blocks_ahead. After a ::TOU_BREAK a positional
+	reader's `offset` is moved back to just after the last delivered block.
 
-	@param[in] fp File pointer to where to read the .INI data from
-	@return Newly allocated structured data
+	@param[in,out] reader Reader
+	@param[in] nbuffers Number of blocks in flight; 0 means 2 (double buffering)
+	@param[in] cb Function to call for each block
+	@param[in] userdata Custom data to be passed to function
+	@return Total bytes delivered to `cb`
 */
-tou_llist_t* tou_ini_parse_fp(FILE* fp);
+size_t tou_block_reader_run_ahead(tou_block_reader* reader, int nbuffers, tou_func3 cb, void* userdata);
+
+/** @} */
 
 /**
-	@brief Parses given buffer as .INI file and constructs structured data.
+	@brief Reads file from `filename`.
 
-	[!] Modifies buffer.
-	Refer to ::tou_ini_parse_fp docs for more info about how data is parsed.
+	Automatically allocates memory and optionally
+	returns amount read (may be set to null).
 
-	@param[in] buf Buffer to read from
-	@return Newly allocated structured data
+	@param[in] filename Either file name or ""/"stdin" to read from stdin
+	@param[out] read_len Optional pointer to where to store file size
+	@return Pointer to loaded file or NULL if error
 */
-tou_llist_t* tou_ini_parse_buffer(char* buf);
+char* tou_read_file(const char* filename, size_t* read_len);
 
 /**
-	Parses a single line as .INI section/property and adds it to structure.
-
-	[!] Modifies data.
-	Refer to ::tou_ini_parse_fp docs for more info about how data is parsed.
+	@brief Reads from `fp`.
 
-	@param[in,out] inicontents Structure to which append
-	@param[in] line Buffer containing line to be parsed
-	@return Continue parsing (::TOU_CONTINUE) or parsing error encountered (::TOU_BREAK)
-*/
-int tou_ini_parse_line(tou_llist_t** inicontents, char* line);
+	Automatically allocates memory and optionally
+	returns amount read (may be set to null).
 
-/**
-	@brief Destroys contents of .INI structure including deallocation
-	of inner structures; assumes head was passed.
+	When `fp` is seekable (a regular file) the remaining size is known
+	up front, so the buffer is allocated once and filled with a single
+	large fread(). Otherwise (pipes, terminals) the buffer grows
+	geometrically while reading.
 
-	@param[in] inicontents Parsed INI structure
+	@param[in] fp FILE* to read from
+	@param[out] read_len Optional pointer to where to store file size
+	@return Pointer to loaded data or NULL on error
 */
-void tou_ini_destroy(tou_llist_t* inicontents);
+char* tou_read_fp(FILE* fp, size_t* read_len);
 
 /**
-	@brief Prints the contents of the parsed .INI structure
-	to stdout in a structured graphical format.
-
-	@param[in] inicontents Parsed INI structure
+	@brief Flags for ::tou_map_file
 */
-void tou_ini_print(tou_llist_t* inicontents);
+enum tou_map_flags {
+	TOU_MAP_READONLY   = 0,      /**< Read-only mapping (default) */
+	TOU_MAP_WRITABLE   = 1 << 0, /**< Private copy-on-write mapping; changes are never written back to the file */
+	TOU_MAP_SEQUENTIAL = 1 << 1, /**< Hint that the data will be read once from front to back (more read-ahead) */
+	TOU_MAP_WILLNEED   = 1 << 2, /**< Hint to start paging the whole file in right away */
+};
 
 /**
-	@addtogroup grp_ini_lower Lower level functions
-	@{
+	@brief File contents loaded by ::tou_map_file
 */
+typedef struct {
+	char* data; /**< File contents, not '\0'-terminated when mapped; NULL for empty files */
+	size_t len; /**< Length of the contents */
+	char mapped; /**< Whether `data` is a mapping (1) or was read into heap memory (0) */
+} tou_mapped_file;
 
 /**
-	@brief Returns pointer to the section element matching given 'section_name'.
+	@brief Maps file `filename` into memory without copying it.
+
+	Regular files are mmap()'d, so loading even very large files costs
+	no copying and only the pages actually touched are read from disk.
+	Pipes, character devices, stdin and platforms without mmap() fall
+	back to reading the whole input into heap memory (`mapped` is then 0
+	and the data is '\0'-terminated and writable).
+
+	A mapping has no terminating '\0' and is read-only unless
+	::TOU_MAP_WRITABLE is given. ::TOU_MAP_SEQUENTIAL and ::TOU_MAP_WILLNEED
+	are passed to madvise() (or posix_madvise()) when the platform headers
+	expose either (strict ISO modes need `_DEFAULT_SOURCE`).
+
+	Release with ::tou_unmap_file in either case.
+
+	@code{.c}
+	tou_mapped_file f;
+	if (tou_map_file("dict.txt", &f, TOU_MAP_SEQUENTIAL) == 0) {
+		size_t lines = tou_scount_n(f.data, "\n", f.len);
+		tou_unmap_file(&f);
+	}
+	@endcode
 
-	@param[in] inicontents Pointer to the parsed .INI structure
-	@param[in] section_name 
-	@return Pointer to the section or NULL
+	@param[in] filename Either file name or ""/"stdin" to read from stdin
+	@param[out] file Receives the data and its length
+	@param[in] flags Combination of ::tou_map_flags
+	@return 0 on success, -1 on error
 */
-tou_llist_t* tou_ini_get_section(tou_llist_t* inicontents, const char* section_name);
+int tou_map_file(const char* filename, tou_mapped_file* file, int flags);
 
 /**
-	@brief Returns pointer to the property element matching given 'section_name' and 'key'.
+	@brief Releases the data of a file loaded by ::tou_map_file.
 
-	@param[in] inicontents Pointer to the parsed .INI structure
-	@param[in] section_name 
-	@param[in] key 
-	@return Pointer to the property or NULL
+	@param[in,out] file File to release; reset to empty
 */
-tou_llist_t* tou_ini_get_property(tou_llist_t* inicontents, const char* section_name, const char* key);
+void tou_unmap_file(tou_mapped_file* file);
 
-/** @} */
 
+/* == System/IO control == */
 /**
-	@brief Returns the contents of 'key' under the given 'section_name'.
-
-	@param[in] inicontents Pointer to the parsed .INI structure
-	@param[in] section_name 
-	@param[in] key 
-	@return Pointer to the contents, or NULL
+	@addtogroup grp_file_sysio System/IO control
+	@{
 */
-void* tou_ini_get(tou_llist_t* inicontents, const char* section_name, const char* key);
 
 /**
-	@brief Sets the contents of `key` under the given `section_name`
-	to the specified value, reallocating memory if necessary.
-
-	Returns either pointer to the property (key & value) object that was just stored,
-	the section name if just a new section was stored, or NULL on error;
-
-	Section name must always be present, unlike key and value parameters which may be NULL.
-	If key is NULL or empty(""), only the new section will be created. If the section already
-	exists this is a no-op.
-	If both section name and key are present, value may also be "" or NULL
-	which will both result in being stored as an empty value ("") in the structure.
-
-	@param[in,out] inicontents Pointer to the parsed .INI structure
-	@param[in] section_name 
-	@param[in] key 
-	@param[in] new_value 
-	@return Pointer to the property object, section object, or NULL
-*/
-tou_llist_t* tou_ini_set(tou_llist_t** inicontents, const char* section_name, const char* key, char* new_value);
+	@brief Redirects STDOUT to `/dev/null` (or `NUL:` on Windows)
 
-/**
-	@brief Return a pointer to the llist entry of the matching section, or NULL.
+	Return value should be saved if you wish to
+	restore STDOUT function.
 
-	@param[in] inicontents Pointer to the parsed .INI structure
-	@param[in] section_name 
-	@return Pointer to the section
+	@return New file descriptor for the saved STDOUT
 */
-tou_llist_t* tou_ini_section(tou_llist_t* inicontents, const char* section_name);
+int tou_disable_stdout();
 
 /**
-	@brief Return the value of the matching property in the given section, or NULL.
+	@brief Re-enables STDOUT that had been disabled using
+	the saved file descriptor from previous function.
 
-	@param[in] section Pointer to the parsed .INI structure
-	@param[in] property_name 
-	@return Value of the property
+	@param[in] saved_fd Saved STDOUT fd
 */
-void* tou_ini_property(tou_llist_t* section, const char* property_name);
+void tou_enable_stdout(int saved_fd);
 
 /**
-	@brief Writes .INI structure data to file stream.
-
-	Return error codes:
-	 0 = OK, no error,
-	-1 = NULL received in params,
-	-2 = Cannot write to stream,
-	-3 = Invalid section name encountered in struct,
-	-4 = Invalid property data encountered in struct
-
-	@param[in] inicontents Pointer to the starting element
-	@param[in] fp File* stream to write to
-	@return Zero if successful, error code if failed
+	@brief Shorthand for surrounding a piece of code with ::tou_disable_stdout and ::tou_enable_stdout
 */
-int tou_ini_save_fp(tou_llist_t* inicontents, FILE* fp);
+#ifndef TOU_SILENCE
+#define TOU_SILENCE( ... ) \
+	_tou_g_saved_stdout = tou_disable_stdout(); \
+	__VA_ARGS__ ; \
+	tou_enable_stdout(_tou_g_saved_stdout);
+#endif
 
 /**
-	@brief Exports .INI structure data as JSON to the file stream.
-
-	Return error codes:
-	-  0 = OK, no error,
-	- -1 = NULL received in params,
-	- -2 = Cannot write to stream,
-	- -3 = Invalid section name encountered in struct,
-	- -4 = Invalid property data encountered in struct
-
-	@param[in] inicontents Pointer to the starting element
-	@param[in] fp File* stream to write to
-	@return Zero if successful, error code if failed
+	Filedescriptor handle local to this compilation unit used with ::TOU_SILENCE.
+	Since it isn't surrounded by `#ifdef TOU_IMPLEMENTATION` it'll be declared each time you \#include the header.
 */
-int tou_ini_save_fp_json(tou_llist_t* inicontents, FILE* fp);
-
-/**
-	@brief Exports .INI structure data as XML to the file stream.
-
-	Return error codes:
-	-  0 = OK, no error,
-	- -1 = NULL received in params,
-	- -2 = Cannot write to stream,
-	- -3 = Invalid section name encountered in struct,
-	- -4 = Invalid property data encountered in struct
+static int _tou_g_saved_stdout;
 
-	@param[in] inicontents Pointer to the starting element
-	@param[in] fp File* stream to write to
-	@return Zero if successful, error code if failed
-*/
-int tou_ini_save_fp_xml(tou_llist_t* inicontents, FILE* fp);
 
-#endif
+/** @} */
 
 
 /** @} */
 
 
-/* == Parsers == */
+/* == Linked list == */
 /**
-	@addtogroup grp_parsers_converters Parsers & Converters
+	@addtogroup grp_llist Linked list
 	@{
 */
 
-#ifdef TOU_LLIST_SINGLE_ELEM
-#warning TOU_LLIST_SINGLE_ELEM DEFINED, PARSERS & CONVERTERS DISABLED.
-#else
+/**
+	@cond
+*/
+/** 
+	@brief Address of `dat1` or `dat2` parameter of object.
+	
+	Used when not a simple address of dat1/dat2 where you have tou_llist_t* is required, but rather when
+	you get list as double ptr and you want changes you make to the inner pointer reflect in
+	the original place instead of just locally. This construct is used multiple times when dealing
+	with .INI parser and I got tired of typing it and decided to extract it here.
+	
+	Example: when `section` is a simple pointer you would use:
+	
+		tou_llist_t* list = &(section->dat2); // parentheses for clarity
+	
+	however, if you wanted to reflect changes in the `section` ptr you would have to have `section` as a pointer-to-pointer and:
+	
+		tou_llist_t** list = &((*section)->dat2);
+	
+	which is exactly what this macro does, just professionally cluttered.
+*/
+#ifndef TOU_LLIST_DAT_ADDR
+#define TOU_LLIST_DAT_ADDR(list, param) ((tou_llist_t**)(&((*(list))->param)))
+#endif
+/**
+	@endcond
+*/
+
+/** 
+	@brief Creates/initializes new llist.
+	
+	Define creation of a new llist through \#define so even though it
+	currently doesn't require anything more than =NULL it will be
+	easier to extend in the future if a need for such initializer arises.
+*/
+#ifndef tou_llist_new
+#define tou_llist_new(...) ((TOU_DBG ? (fprintf(stdout,TOU_DEBUG_PREFIX"Creating new llist :: NULL\n"), (void)0) : (void)0) , NULL)
+#endif
+
+/* */
+// typedef tou_llist_t* tou_llist_elem;
+/* */
+// #define TOU_LLIST_UNPACK(elem) (*(elem))->dat1,(*(elem))->dat2
 
 /**
-	@brief Parses "parameter string" and returns a llist of key-value pairs,
-		looking at the whole string (strlen will be used)
+	@brief Appends a brand new element to the list/given element and updates it in place.
+	
+	Additionally, returns a pointer to the newly created element.
 
-	Extra whitespaces are ignored and pairs may be key-only (values may be empty).
+	@param[in,out] elem Address of the element (tou_llist_t**)
+	@param[in] dat1 Data 1
+	@param[in] dat2 Data 2
+	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
+	@param[in] dat2_is_dynalloc Should dat2 be free()'d when destroying list?
+	@return Pointer to the newly created element
+*/
 
-	Example:
-		` 5 adjust abc=   def     123=456 	`
-	Is returned as llist where elements are:
-		`{{"5", NULL}, {"adjust", NULL}, {"abc", "def"}, {"123", "456"}}`
+tou_llist_t* tou_llist_append
+(
+	tou_llist_t** elem,
+	void* dat1,
+#ifndef TOU_LLIST_SINGLE_ELEM
+	void* dat2,
+#endif
+	char dat1_is_dynalloc
+#ifndef TOU_LLIST_SINGLE_ELEM
+	, char dat2_is_dynalloc
+#endif
+);
 
-	@param[in] str Pointer to parse
-	@param[in] param_sep String used to split pairs
-	@param[in] keyval_sep String used to split key-value pairs
-	@return Pairs in llist
+/**
+	@brief Appends a brand new element to the list/given element which
+	contains only `dat1` and if the pointer was the head, updates it in place.
+	
+	`dat2` is set to a default of NULL and 0.
+	Additionally, returns a pointer to the newly created element.
+
+	@param[in,out] elem Address of the element (tou_llist_t**)
+	@param[in] dat1 Data 1
+	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
+	@return Pointer to the newly created element
 */
-tou_llist_t* tou_paramparse(char* str, const char* param_sep, const char* keyval_sep);
+tou_llist_t* tou_llist_appendone(tou_llist_t** elem, void* dat1, char dat1_is_dynalloc);
 
 /**
-	@brief Parses "parameter string" and returns a llist of key-value pairs
+	@brief Prepends a brand new element to the list/given element.
+	
+	Additionally, returns a pointer to the newly created element.
 
-	Extra whitespaces are ignored and pairs may be key-only (values may be empty).
+	@param[in,out] elem Address of the element (tou_llist_t**)
+	@param[in] dat1 Data 1
+	@param[in] dat2 Data 2
+	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
+	@param[in] dat2_is_dynalloc Should dat2 be free()'d when destroying list?
+	@return Pointer to the newly created element
+*/
 
-	Example:
-		` 5 adjust abc=   def     123=456 	`
-	Is returned as llist where elements are:
-		`{{"5", NULL}, {"adjust", NULL}, {"abc", "def"}, {"123", "456"}}`
+tou_llist_t* tou_llist_prepend
+(
+	tou_llist_t** elem,
+	void* dat1,
+#ifndef TOU_LLIST_SINGLE_ELEM
+	void* dat2,
+#endif
+	char dat1_is_dynalloc
+#ifndef TOU_LLIST_SINGLE_ELEM
+	, char dat2_is_dynalloc
+#endif
+);
 
-	@param[in] str Pointer to parse
-	@param[in] param_sep String used to split pairs
-	@param[in] keyval_sep String used to split key-value pairs
-	@param[in] maxlen Looks only at the first `maxlen` characters in str
-	@return Pairs in llist
+/**
+	@brief Prepends a brand new element to the list/given
+	element which only contains `dat1`.
+	
+	`dat2` is set to a default of NULL and 0.
+	Additionally, returns a pointer to the newly created element.
+
+	@param[in,out] elem Address of the element (tou_llist_t**)
+	@param[in] dat1 Data 1
+	@param[in] dat1_is_dynalloc Should dat1 be free()'d when destroying list?
+	@return Pointer to the newly created element
 */
-tou_llist_t* tou_paramparse_n(char* str, const char* param_sep, const char* keyval_sep, size_t maxlen);
+tou_llist_t* tou_llist_prependone(tou_llist_t** elem, void* dat1, char dat1_is_dynalloc);
 
 /**
-	@brief Attempts to print "params" parsed by ::tou_paramparse or ::tou_paramparse_n
+	@brief Traverses elements using .next or .prev and frees each one
+	including copied category string
 
-	@param[in] params List containing params
+	@param[in] list Either head or tail element
 */
-void tou_paramprint(tou_llist_t* params);
+void tou_llist_destroy(tou_llist_t* list);
 
-#endif
+/**
+	@brief Removes an element from llist and deallocates it
 
+	If you were to for example remove the head you should assign
+	the return value to something or else you will be left with
+	an invalid pointer and a segfault because this function simply
+	reconnects .prev and .next if they exist, and frees the element.
+	
+	If `elem` was the head, function will return .prev to be used as
+	the new head. Otherwise, it will return .next which may be used
+	or ignored.
 
-/** @} */
+	@param[in] elem Pointer to the element to be removed
+	@return Element that should optionally take `elem`'s place
+*/
+tou_llist_t* tou_llist_remove(tou_llist_t* elem);
 
+/**
+	@brief Disconnects an element from llist but does not deallocate it.
+	You should destroy it by calling ::tou_llist_free_element or manually.
+	
+	@param[in] elem Pointer to the element to be removed
+	@return Pointer to the element popped from llist
+*/
+tou_llist_t* tou_llist_pop(tou_llist_t* elem);
 
-#ifdef __cplusplus
-}
-#endif
+/**
+	@brief Frees an element and its contents.
 
-#endif // __TOU_H_
+	Do NOT use on an element still associated with list;
+	use only on a ::tou_llist_pop'd elem for example.
 
+	@param[in] elem Pointer to the element to be freed
+*/
+void tou_llist_free_element(tou_llist_t* elem);
 
-// ==============================================================
-// ||                       IMPLEMENTATION                     ||
-// ==============================================================
+/**
+	@brief Traverses the whole list using `.next` and returns the last element
+	that was added into list (where `.next` is NULL)
 
+	@param[in] list Element of type tou_llist_t*
+	@return Pointer to the head element
+*/
+tou_llist_t* tou_llist_get_head(tou_llist_t* list);
 
-#ifdef TOU_IMPLEMENTATION
-#if defined(TOU_IMPLEMENTATION_DONE)
-#pragma error "TOU_IMPLEMENTATION already defined somewhere!"
-#else
+/**
+	@brief Traverses the whole list using `.prev` and returns the first element
+	that was added to list (where `.prev` is NULL)
 
-#define TOU_IMPLEMENTATION_DONE
+	@param[in] list Element of type ::tou_llist_t*
+	@return Pointer to the tail element
+*/
+tou_llist_t* tou_llist_get_tail(tou_llist_t* list);
 
+/**
+	@brief Returns the element that was added to the list last.
+	
+	Alias for ::tou_llist_get_head.
 
-////////////////////////////////////////
-///             Strings              ///
-////////////////////////////////////////
+	@param[in] list Element of type ::tou_llist_t*
+	@return Pointer to the newest element
+*/
+tou_llist_t* tou_llist_get_newest(tou_llist_t* list);
 
+/**
+	@brief Returns the element that was added to the list first.
+	
+	Alias for ::tou_llist_get_tail.
 
-/*  */
-size_t tou_strlcpy(char* dst, const char* src, size_t size)
-{
-	size_t src_len;
+	@param[in] list Element of type ::tou_llist_t*
+	@return Pointer to the oldest element
+*/
+tou_llist_t* tou_llist_get_oldest(tou_llist_t* list);
 
-	src_len = strlen (src);
-	if (size > 0)
-	{
-		size_t dst_len = size - 1;
-		if (src_len < dst_len)
-			dst_len = src_len;
-		memcpy (dst, src, dst_len);
-		dst[dst_len] = '\0';
+/**
+	@brief Returns the element added after `elem`.
+
+	Returns `.next` of the `elem`.
+
+	@param[in] elem Element of type ::tou_llist_t*
+	@return Pointer to the requested element
+*/
+tou_llist_t* tou_llist_get_newer(tou_llist_t* elem);
+
+/**
+	@brief Returns the element added before `elem`.
+
+	Returns `.prev` of the `elem`.
+
+	@param[in] elem Element of type ::tou_llist_t*
+	@return Pointer to the requested element
+*/
+tou_llist_t* tou_llist_get_older(tou_llist_t* elem);
+
+/**
+	@brief Updates `elem` to point to the element added after itself.
+
+	`elem` is updated to `.next` of the `elem`.
+	That same `.next` is additionally returned from function.
+
+	@param[in,out] elem Address of the element
+	@return Pointer to the element
+*/
+tou_llist_t* tou_llist_next_newer(tou_llist_t** elem);
+
+/**
+	@brief Updates `elem` to point to the element added before itself.
+
+	`elem` is updated to `.prev` of the `elem`.
+	That same `.next` is additionally returned from function.
+
+	@param[in,out] elem Address of the element
+	@return Pointer to the element
+*/
+tou_llist_t* tou_llist_next_older(tou_llist_t** elem);
+
+/**
+	@brief Checks if element is head of the list
+	(`.next` should be NULL)
+
+	@param[in] elem Element to check
+	@return 1 or 0 depending on result
+*/
+char tou_llist_is_head(tou_llist_t* elem);
+
+/**
+	@brief Checks if element is tail of the list
+	(`.prev` should be NULL)
+
+	@param[in] elem Element to check
+	@return 1 or 0 depending on result
+*/
+char tou_llist_is_tail(tou_llist_t* elem);
+
+/**
+	@brief Iterate through and call the specified function for each element
+	Automatically checks whether given element is head or tail and 
+	iterates accordingly.
+	If given function returns a 0 the iteration terminates early.
+
+	@param[in] list Head or tail of the list
+	@param[in] cb Function to be called for each element
+*/
+void tou_llist_iter(tou_llist_t* list, tou_func cb);
+
+/**
+	@brief Traverses the list starting from the passed element and tries
+	to find the first matching element by simple equals-comparison
+	using both parameters at the same time.
+
+	@param[in] list Element to start the search from
+	@param[in] dat1 Comparison value
+	@param[in] dat2 Comparison value (if enabled)
+	@return Found element or NULL
+*/
+tou_llist_t* tou_llist_find_exact
+(
+	tou_llist_t* list,
+	void* dat1
+#ifndef TOU_LLIST_SINGLE_ELEM
+	, void* dat2
+#endif
+);
+
+/**
+	@brief Traverses the list starting from the passed element and tries
+	to find the first matching element by simple equals-comparison of param.
+
+	@param[in] list Element to start the search from
+	@param[in] dat1 Comparison value
+	@return Found element or NULL
+*/
+tou_llist_t* tou_llist_find_exactone(tou_llist_t* list, void* dat1);
+
+/**
+	@brief Traverses the list starting from the passed element and tries
+	to find the first matching element on the basis: if dat1 is not null,
+	tries to match it as a nul-terminated string
+
+	@param[in] list Element to start the search from
+	@param[in] dat1 Comparison value
+	@return Found element or NULL
+*/
+tou_llist_t* tou_llist_find_key(tou_llist_t* list, void* dat1);
+
+/**
+	@brief Traverses the list starting from the passed element and tries
+	to find the first matching element by checking the return value
+	of the given callback comparison function.
+
+	If function's return value equals 0 the element is considered matched
+	and the search terminates, otherwise search continues.
+
+	@param[in] list Element to start the search from
+	@param[in] cb Custom comparison function
+	@param[in] userdata Custom data to be given to the cb() function
+	@return Found element or NULL
+*/
+tou_llist_t* tou_llist_find_func(tou_llist_t* list, tou_func2 cb, void* userdata);
+
+/**
+	@brief Goes through the list and returns amount of elements.
+
+	@param[in] list List to count elements
+	@return Number of elements
+*/
+size_t tou_llist_len(tou_llist_t* list);
+
+/**
+	@brief Constructs a dynamically allocated ARRAY containing
+	only .dat1 properties (stored as void*).
+
+	@param[in] list Linked list to construct array from
+	@param[out] len Optional length of the array/llist
+	@return Void* array of .dat1's
+*/
+void** tou_llist_gather_dat1(tou_llist_t* list, size_t* len);
+
+/**
+	@brief Constructs a dynamically allocated ARRAY containing
+	only .dat2 properties (stored as void*).
+
+	@param[in] list Linked list to construct array from
+	@param[out] len Optional length of the array/llist
+	@return Void* array of .dat2's
+*/
+#ifndef TOU_LLIST_SINGLE_ELEM
+void** tou_llist_gather_dat2(tou_llist_t* list, size_t* len);
+#endif
+
+/** @brief Convenience alias for gathering first element */
+#define tou_llist_gather tou_llist_gather_dat1
+
+/**
+	@brief Macro that goes through the elements from head to tail and prints
+	their `.dat1` and `.dat2` fields using given format specifiers.
+
+	If TOU_LLIST_SINGLE_ELEM is defined it will accept only `dat1_spec`
+	and print only `.dat1` (`dat2_spec` will be ignored if specified).
+
+	It is not enough if for example your wish is to print the value
+	of `int*`, but if you just want that pointer, string or if you
+	stored value itself into the field it will come in handy.
+
+	@param[in] llist List to print
+	@param[in] dat1_spec Format specifier for `.dat1`
+	@param[in] dat2_spec Format specifier for `.dat2`
+*/
+#ifndef tou_llist_print
+#ifndef TOU_LLIST_SINGLE_ELEM
+
+	#define tou_llist_print(llist, dat1_spec, dat2_spec, ...)                          \
+	{                                                                                  \
+		tou_llist_t* copy = tou_llist_get_newest(llist);                               \
+		printf("List contents: (%d)\n", tou_llist_len(copy));                          \
+		while (copy) {                                                                 \
+			printf("  |\n  " dat1_spec " :: " dat2_spec "\n", copy->dat1, copy->dat2); \
+			copy = tou_llist_get_older(copy);                                          \
+		}                                                                              \
+	} (void)0
+
+#else
+
+	#define tou_llist_print(llist, dat1_spec, ...)            \
+	{                                                         \
+		tou_llist_t* copy = tou_llist_get_newest(llist);      \
+		printf("List contents: (%d)\n", tou_llist_len(copy)); \
+		while (copy) {                                        \
+			printf("  |\n  " dat1_spec "\n", copy->dat1);     \
+			copy = tou_llist_get_older(copy);                 \
+		}                                                     \
+	} (void)0
+
+#endif
+#endif
+
+/**
+	@brief Macro that goes through the elements from tail to head and prints
+	their `.dat1` and `.dat2` fields using given format specifiers.
+
+	If TOU_LLIST_SINGLE_ELEM is defined it will accept only `dat1_spec`
+	and print only `.dat1` (`dat2_spec` will be ignored if specified).
+
+	It is not enough if for example your wish is to print the value
+	of `int*`, but if you just want that pointer, string or if you
+	stored value itself into the field it will come in handy.
+
+	@param[in] llist List to print
+	@param[in] dat1_spec Format specifier for `.dat1`
+	@param[in] dat2_spec Format specifier for `.dat2`
+*/
+#ifndef tou_llist_print_tail
+#ifndef TOU_LLIST_SINGLE_ELEM
+
+	#define tou_llist_print_tail(llist, dat1_spec, dat2_spec, ...)                 \
+	{                                                                              \
+		tou_llist_t* copy = tou_llist_get_oldest(llist);                           \
+		printf("List contents: (%d)\n", tou_llist_len(copy));                      \
+		while (copy) {                                                             \
+			printf("  |\n  "dat1_spec" :: "dat2_spec"\n", copy->dat1, copy->dat2); \
+			copy = tou_llist_get_newer(copy);                                      \
+		}                                                                          \
+	} (void)0
+
+#else
+
+	#define tou_llist_print_tail(llist, dat1_spec, ...)       \
+	{                                                         \
+		tou_llist_t* copy = tou_llist_get_oldest(llist);      \
+		printf("List contents: (%d)\n", tou_llist_len(copy)); \
+		while (copy) {                                        \
+			printf("  |\n  "dat1_spec"\n", copy->dat1);       \
+			copy = tou_llist_get_newer(copy);                 \
+		}                                                     \
+	} (void)0
+
+#endif
+#endif
+
+
+/** @} */
+
+
+/* == Stack == */
+/**
+	@addtogroup grp_stack Stack
+	@{
+*/
+
+/** @brief Make a stack alias for convenience */
+typedef tou_llist_t tou_stack;
+
+/**
+	@brief Creates a new stack object
+
+	@return Stack object
+*/
+tou_llist_t* tou_stack_new();
+
+/**
+	@brief Destroys existing stack object
+
+	@param[in] stack Object to destroy
+*/
+void tou_stack_destroy(tou_llist_t* stack);
+
+/**
+	@brief Returns the length of the stack
+
+	@param[in] stack Stack object
+	@return Stack length
+*/
+size_t tou_stack_len(tou_llist_t* stack);
+
+/**
+	@brief Pushes a new element to the top of the stack
+
+	@param[in] stack Stack object
+	@param[in] elem Element to push 
+*/
+void tou_stack_push(tou_llist_t** stack, void* elem);
+
+/**
+	@brief Pops an element from the top of the stack
+
+	@param[in] stack Pointer to the stack object
+	@return Element
+*/
+void* tou_stack_pop(tou_llist_t** stack);
+
+
+/** @} */
+
+
+/* == Queue == */
+/**
+	@addtogroup grp_queue Queue
+	@{
+*/
+
+/** @brief Make a queue alias for convenience */
+typedef tou_llist_t tou_queue;
+
+/**
+	@brief Creates a new queue object
+
+	@return Queue object
+*/
+tou_llist_t* tou_queue_new();
+
+/**
+	@brief Destroys existing queue object
+
+	@param[in] queue Object to destroy
+*/
+void tou_queue_destroy(tou_llist_t* queue);
+
+/**
+	@brief Returns the length of the queue
+
+	@param[in] queue Queue object
+	@return Queue length
+*/
+size_t tou_queue_len(tou_llist_t* queue);
+
+/**
+	@brief Pushes a new element to the top of the Queue
+
+	@param[in] queue Queue object
+	@param[in] elem Element to push 
+*/
+void tou_queue_push(tou_llist_t** queue, void* elem);
+
+/**
+	@brief Pops an element from the top of the Queue
+
+	@param[in] queue Pointer to the queue object
+	@return Element
+*/
+void* tou_queue_pop(tou_llist_t** queue);
+
+
+/** @} */
+
+
+/* == INI parser == */
+/**
+	@addtogroup grp_ini INI operations
+	Loading, saving and working with .ini files.
+
+	Loaded data is internally structured as a linked list (::tou_llist_t)
+	of INI sections with first parameter being the section name and second
+	being a sub-linked-list containing its properties where first and
+	second property represent the property's key and value respectively.
+	You may get a relatively similar visual by calling ::tou_ini_print.
+	```
+	<SECTION> -(first)-> "section 1"
+	 :     |
+	 :  (second)
+	 :     |
+	 :     +-> <PROPERTY> -(first)-> "persons name"
+	 :     :        |
+	 :     :     (second)
+  	 :     :        |
+	 :     :        +-> "John"
+	 :     :
+	 :     +-> <PROPERTY> -> "persons age"
+	 :             |     
+     :             +-> "654"
+	 :
+	<SECTION> -> "section 2"
+	 :     |
+	 :     +-> <PROPERTY> -> "Text contents"
+	 :     :        |
+	 :     .        +-> "Lorem ipsum dolor sit amet,    and  even  more  text ...     "
+     .       
+	```
+
+	@{
+*/
+
+#ifdef TOU_LLIST_SINGLE_ELEM
+#warning TOU_LLIST_SINGLE_ELEM DEFINED, TOU_INI DISABLED.
+#else
+
+
+/**
+	@brief Parses given FILE* as .INI file and constructs structured data.
+
+	Parser supports using semicolon (;) and hashtag (#) for comments,
+	however they must be on a separate line by themselves.
+	Specifying the same section name more than once is not supported (that
+	may change in the future where the definitions would merge and "flatten"
+	into one combined section).
+	
+	Whitespaces may be added between sections, properties and section name
+	brackets for better readability. When specifying properties both keys
+	and values may have *some* whitespaces in them.
+	However, all whitespaces at the beginning and the end of the *key* will be
+	removed, as well as all whitespaces at the end of the *value*. If the value
+	starts with a whitespace, only that single whitespace will be removed.
+	Keep in mind that keys having whitespaces inside of them will be sensitive
+	to them when reading the data.
+
+	Structured data is constructed as two layers of llists where the primary list
+	that gets returned from function represents sections in .INI file where the
+	section names and properties are stored in .dat1 and .dat2 fields respectively.
+	Properties in .dat2 are stored as sub-llist where keys and values are allocated
+	and are stored as strings in .dat1 and .dat2 fields respectively.
+
+	@param[in] fp File pointer to where to read the .INI data from
+	@return Newly allocated structured data
+*/
+tou_llist_t* tou_ini_parse_fp(FILE* fp);
+
+/**
+	@brief Parses given buffer as .INI file and constructs structured data.
+
+	[!] Modifies buffer.
+	Refer to ::tou_ini_parse_fp docs for more info about how data is parsed.
+
+	@param[in] buf Buffer to read from
+	@return Newly allocated structured data
+*/
+tou_llist_t* tou_ini_parse_buffer(char* buf);
+
+/**
+	Parses a single line as .INI section/property and adds it to structure.
+
+	[!] Modifies data.
+	Refer to ::tou_ini_parse_fp docs for more info about how data is parsed.
+
+	@param[in,out] inicontents Structure to which append
+	@param[in] line Buffer containing line to be parsed
+	@return Continue parsing (::TOU_CONTINUE) or parsing error encountered (::TOU_BREAK)
+*/
+int tou_ini_parse_line(tou_llist_t** inicontents, char* line);
+
+/**
+	@brief Destroys contents of .INI structure including deallocation
+	of inner structures; assumes head was passed.
+
+	@param[in] inicontents Parsed INI structure
+*/
+void tou_ini_destroy(tou_llist_t* inicontents);
+
+/**
+	@brief Prints the contents of the parsed .INI structure
+	to stdout in a structured graphical format.
+
+	@param[in] inicontents Parsed INI structure
+*/
+void tou_ini_print(tou_llist_t* inicontents);
+
+/**
+	@addtogroup grp_ini_lower Lower level functions
+	@{
+*/
+
+/**
+	@brief Returns pointer to the section element matching given 'section_name'.
+
+	@param[in] inicontents Pointer to the parsed .INI structure
+	@param[in] section_name 
+	@return Pointer to the section or NULL
+*/
+tou_llist_t* tou_ini_get_section(tou_llist_t* inicontents, const char* section_name);
+
+/**
+	@brief Returns pointer to the property element matching given 'section_name' and 'key'.
+
+	@param[in] inicontents Pointer to the parsed .INI structure
+	@param[in] section_name 
+	@param[in] key 
+	@return Pointer to the property or NULL
+*/
+tou_llist_t* tou_ini_get_property(tou_llist_t* inicontents, const char* section_name, const char* key);
+
+/** @} */
+
+/**
+	@brief Returns the contents of 'key' under the given 'section_name'.
+
+	@param[in] inicontents Pointer to the parsed .INI structure
+	@param[in] section_name 
+	@param[in] key 
+	@return Pointer to the contents, or NULL
+*/
+void* tou_ini_get(tou_llist_t* inicontents, const char* section_name, const char* key);
+
+/**
+	@brief Sets the contents of `key` under the given `section_name`
+	to the specified value, reallocating memory if necessary.
+
+	Returns either pointer to the property (key & value) object that was just stored,
+	the section name if just a new section was stored, or NULL on error;
+
+	Section name must always be present, unlike key and value parameters which may be NULL.
+	If key is NULL or empty(""), only the new section will be created. If the section already
+	exists this is a no-op.
+	If both section name and key are present, value may also be "" or NULL
+	which will both result in being stored as an empty value ("") in the structure.
+
+	@param[in,out] inicontents Pointer to the parsed .INI structure
+	@param[in] section_name 
+	@param[in] key 
+	@param[in] new_value 
+	@return Pointer to the property object, section object, or NULL
+*/
+tou_llist_t* tou_ini_set(tou_llist_t** inicontents, const char* section_name, const char* key, char* new_value);
+
+/**
+	@brief Return a pointer to the llist entry of the matching section, or NULL.
+
+	@param[in] inicontents Pointer to the parsed .INI structure
+	@param[in] section_name 
+	@return Pointer to the section
+*/
+tou_llist_t* tou_ini_section(tou_llist_t* inicontents, const char* section_name);
+
+/**
+	@brief Return the value of the matching property in the given section, or NULL.
+
+	@param[in] section Pointer to the parsed .INI structure
+	@param[in] property_name 
+	@return Value of the property
+*/
+void* tou_ini_property(tou_llist_t* section, const char* property_name);
+
+/**
+	@brief Writes .INI structure data to file stream.
+
+	Return error codes:
+	 0 = OK, no error,
+	-1 = NULL received in params,
+	-2 = Cannot write to stream,
+	-3 = Invalid section name encountered in struct,
+	-4 = Invalid property data encountered in struct
+
+	@param[in] inicontents Pointer to the starting element
+	@param[in] fp File* stream to write to
+	@return Zero if successful, error code if failed
+*/
+int tou_ini_save_fp(tou_llist_t* inicontents, FILE* fp);
+
+/**
+	@brief Exports .INI structure data as JSON to the file stream.
+
+	Return error codes:
+	-  0 = OK, no error,
+	- -1 = NULL received in params,
+	- -2 = Cannot write to stream,
+	- -3 = Invalid section name encountered in struct,
+	- -4 = Invalid property data encountered in struct
+
+	@param[in] inicontents Pointer to the starting element
+	@param[in] fp File* stream to write to
+	@return Zero if successful, error code if failed
+*/
+int tou_ini_save_fp_json(tou_llist_t* inicontents, FILE* fp);
+
+/**
+	@brief Exports .INI structure data as XML to the file stream.
+
+	Return error codes:
+	-  0 = OK, no error,
+	- -1 = NULL received in params,
+	- -2 = Cannot write to stream,
+	- -3 = Invalid section name encountered in struct,
+	- -4 = Invalid property data encountered in struct
+
+	@param[in] inicontents Pointer to the starting element
+	@param[in] fp File* stream to write to
+	@return Zero if successful, error code if failed
+*/
+int tou_ini_save_fp_xml(tou_llist_t* inicontents, FILE* fp);
+
+#endif
+
+
+/** @} */
+
+
+/* == Parsers == */
+/**
+	@addtogroup grp_parsers_converters Parsers & Converters
+	@{
+*/
+
+#ifdef TOU_LLIST_SINGLE_ELEM
+#warning TOU_LLIST_SINGLE_ELEM DEFINED, PARSERS & CONVERTERS DISABLED.
+#else
+
+/**
+	@brief Parses "parameter string" and returns a llist of key-value pairs,
+		looking at the whole string (strlen will be used)
+
+	Extra whitespaces are ignored and pairs may be key-only (values may be empty).
+
+	Example:
+		` 5 adjust abc=   def     123=456 	`
+	Is returned as llist where elements are:
+		`{{"5", NULL}, {"adjust", NULL}, {"abc", "def"}, {"123", "456"}}`
+
+	@param[in] str Pointer to parse
+	@param[in] param_sep String used to split pairs
+	@param[in] keyval_sep String used to split key-value pairs
+	@return Pairs in llist
+*/
+tou_llist_t* tou_paramparse(char* str, const char* param_sep, const char* keyval_sep);
+
+/**
+	@brief Parses "parameter string" and returns a llist of key-value pairs
+
+	Extra whitespaces are ignored and pairs may be key-only (values may be empty).
+
+	Example:
+		` 5 adjust abc=   def     123=456 	`
+	Is returned as llist where elements are:
+		`{{"5", NULL}, {"adjust", NULL}, {"abc", "def"}, {"123", "456"}}`
+
+	@param[in] str Pointer to parse
+	@param[in] param_sep String used to split pairs
+	@param[in] keyval_sep String used to split key-value pairs
+	@param[in] maxlen Looks only at the first `maxlen` characters in str
+	@return Pairs in llist
+*/
+tou_llist_t* tou_paramparse_n(char* str, const char* param_sep, const char* keyval_sep, size_t maxlen);
+
+/**
+	@brief Attempts to print "params" parsed by ::tou_paramparse or ::tou_paramparse_n
+
+	@param[in] params List containing params
+*/
+void tou_paramprint(tou_llist_t* params);
+
+#endif
+
+
+/** @} */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __TOU_H_
+
+
+// ==============================================================
+// ||                       IMPLEMENTATION                     ||
+// ==============================================================
+
+
+#ifdef TOU_IMPLEMENTATION
+#if defined(TOU_IMPLEMENTATION_DONE)
+#pragma error "TOU_IMPLEMENTATION already defined somewhere!"
+#else
+
+#define TOU_IMPLEMENTATION_DONE
+
+
+////////////////////////////////////////
+///             Threads              ///
+////////////////////////////////////////
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+#ifndef TOU_NO_THREADS
+
+#ifdef _WIN32
+typedef HANDLE _tou_thread_t;
+typedef CRITICAL_SECTION _tou_mutex_t;
+typedef CONDITION_VARIABLE _tou_cond_t;
+
+typedef struct { tou_func fn; void* arg; } _tou_thread_start_t;
+
+/*  */
+static DWORD WINAPI _tou_thread_trampoline(LPVOID param)
+{
+	_tou_thread_start_t start = *(_tou_thread_start_t*)param;
+	free(param);
+	start.fn(start.arg);
+	return 0;
+}
+
+/*  */
+static int _tou_thread_create(_tou_thread_t* thread, tou_func fn, void* arg)
+{
+	_tou_thread_start_t* start = malloc(sizeof *start);
+	if (start == NULL)
+		return 0;
+	start->fn = fn;
+	start->arg = arg;
+	if ((*thread = CreateThread(NULL, 0, _tou_thread_trampoline, start, 0, NULL)) == NULL) {
+		free(start);
+		return 0;
+	}
+	return 1;
+}
+
+static void _tou_thread_join(_tou_thread_t thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+static void _tou_mutex_init(_tou_mutex_t* mtx)     { InitializeCriticalSection(mtx); }
+static void _tou_mutex_destroy(_tou_mutex_t* mtx)  { DeleteCriticalSection(mtx); }
+static void _tou_mutex_lock(_tou_mutex_t* mtx)     { EnterCriticalSection(mtx); }
+static void _tou_mutex_unlock(_tou_mutex_t* mtx)   { LeaveCriticalSection(mtx); }
+static void _tou_cond_init(_tou_cond_t* cnd)       { InitializeConditionVariable(cnd); }
+static void _tou_cond_destroy(_tou_cond_t* cnd)    { (void)cnd; }
+static void _tou_cond_wait(_tou_cond_t* cnd, _tou_mutex_t* mtx) { SleepConditionVariableCS(cnd, mtx, INFINITE); }
+static void _tou_cond_broadcast(_tou_cond_t* cnd)  { WakeAllConditionVariable(cnd); }
+
+#else
+#include <pthread.h>
+
+typedef pthread_t _tou_thread_t;
+typedef pthread_mutex_t _tou_mutex_t;
+typedef pthread_cond_t _tou_cond_t;
+
+static int _tou_thread_create(_tou_thread_t* thread, tou_func fn, void* arg) { return pthread_create(thread, NULL, fn, arg) == 0; }
+static void _tou_thread_join(_tou_thread_t thread) { pthread_join(thread, NULL); }
+static void _tou_mutex_init(_tou_mutex_t* mtx)     { pthread_mutex_init(mtx, NULL); }
+static void _tou_mutex_destroy(_tou_mutex_t* mtx)  { pthread_mutex_destroy(mtx); }
+static void _tou_mutex_lock(_tou_mutex_t* mtx)     { pthread_mutex_lock(mtx); }
+static void _tou_mutex_unlock(_tou_mutex_t* mtx)   { pthread_mutex_unlock(mtx); }
+static void _tou_cond_init(_tou_cond_t* cnd)       { pthread_cond_init(cnd, NULL); }
+static void _tou_cond_destroy(_tou_cond_t* cnd)    { pthread_cond_destroy(cnd); }
+static void _tou_cond_wait(_tou_cond_t* cnd, _tou_mutex_t* mtx) { pthread_cond_wait(cnd, mtx); }
+static void _tou_cond_broadcast(_tou_cond_t* cnd)  { pthread_cond_broadcast(cnd); }
+
+#endif
+
+#endif // TOU_NO_THREADS
+
+
+/* Number of CPUs available, at least 1 */
+static int _tou_cpu_count(void)
+{
+	int n = 1;
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	n = (int)info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	n = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return (n > 0) ? n : 1;
+}
+
+
+////////////////////////////////////////
+///             Strings              ///
+////////////////////////////////////////
+
+
+/*
+	CPU feature detection for the SIMD kernels; evaluated once.
+*/
+enum {
+	_TOU_CPU_SSE2     = 1 << 0,
+	_TOU_CPU_AVX2     = 1 << 1,
+	_TOU_CPU_AVX512BW = 1 << 2,
+	_TOU_CPU_AVX512VBMI = 1 << 3,
+};
+
+/*
+	Lazily initialized globals (the feature bits, the kernel pointers) are
+	only ever set to the same value, so relaxed atomic accesses are enough
+	to make a first use from several threads at once well defined.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+#define _TOU_LOAD_RELAXED(ptr) __atomic_load_n((ptr), __ATOMIC_RELAXED)
+#define _TOU_STORE_RELAXED(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELAXED)
+#else
+#define _TOU_LOAD_RELAXED(ptr) (*(ptr))
+#define _TOU_STORE_RELAXED(ptr, val) (*(ptr) = (val))
+#endif
+
+/*  */
+static int _tou_cpu_features(void)
+{
+	static int features = -1;
+
+	int cached = _TOU_LOAD_RELAXED(&features);
+	if (cached < 0) {
+		int f = 0;
+#ifdef _TOU_SIMD_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("sse2"))     f |= _TOU_CPU_SSE2;
+		if (__builtin_cpu_supports("avx2"))     f |= _TOU_CPU_AVX2;
+		if (__builtin_cpu_supports("avx512bw")) f |= _TOU_CPU_AVX512BW;
+		if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi")) f |= _TOU_CPU_AVX512VBMI;
+#endif
+		TOU_PRINTD("[cpu_features] sse2=%d avx2=%d avx512bw=%d avx512vbmi=%d\n",
+			!!(f & _TOU_CPU_SSE2), !!(f & _TOU_CPU_AVX2), !!(f & _TOU_CPU_AVX512BW), !!(f & _TOU_CPU_AVX512VBMI));
+		_TOU_STORE_RELAXED(&features, f);
+		cached = f;
+	}
+	return cached;
+}
+
+
+/*  */
+size_t tou_strlcpy(char* dst, const char* src, size_t size)
+{
+	size_t src_len;
+
+	src_len = strlen (src);
+	if (size > 0)
+	{
+		size_t dst_len = size - 1;
+		if (src_len < dst_len)
+			dst_len = src_len;
+		memcpy (dst, src, dst_len);
+		dst[dst_len] = '\0';
+	}
+	return src_len;
+}
+
+
+/*  */
+size_t tou_strlcat(char* dst, const char* src, size_t size)
+{
+	size_t src_len, dst_len;
+
+	src_len = strlen (src);
+	dst_len = strlen (dst);
+	if (size > 0 && dst_len < size) 
+	{
+		size_t copy_cnt = size - dst_len - 1;
+		if (src_len < copy_cnt)
+			copy_cnt = src_len;
+		memcpy (dst + dst_len, src, copy_cnt);
+		dst[dst_len + copy_cnt] = '\0';
+	}
+	return src_len + dst_len;
+}
+
+
+/*  */
+size_t tou_strlen(const char* str)
+{
+	if (!str) return 0;
+	return strlen(str);
+}
+
+
+/*  */
+char* tou_strdup(const char* src)
+{
+	size_t src_len = strlen(src);
+	char* copy;
+	if ((copy = malloc(src_len + 1)) == NULL)
+		return NULL;
+	// tou_strlcpy(copy, src, src_len + 1);
+	memcpy(copy, src, src_len + 1);
+	return copy;
+}
+
+
+/*  */
+char* tou_strndup(const char* src, size_t size)
+{
+	size_t src_len = strlen(src);
+	char* copy = NULL;
+
+	if (size > 0) {
+		size_t copy_len = size;
+		if (src_len < copy_len)
+			copy_len = src_len;
+		if ((copy = malloc(copy_len + 1)) == NULL)
+			return NULL;
+		// tou_strlcpy(copy, src, copy_len + 1);
+		memcpy(copy, src, copy_len + 1);
+	}
+	return copy;
+}
+
+
+/*
+	Byte scanning kernels.
+
+	Forward scans over NUL-terminated strings only ever load whole aligned
+	blocks (words or vectors) so they may read past the terminator, but never
+	into the next page. Such loads are invisible to the program but not to
+	ASan, hence _TOU_NO_ASAN. Backward scans know the length and stay inside it.
+*/
+#if defined(__GNUC__) || defined(__clang__)
+#define _TOU_NO_ASAN __attribute__((no_sanitize_address))
+#else
+#define _TOU_NO_ASAN
+#endif
+
+#define _TOU_SWAR_ONES  ((size_t)-1 / 0xFF)
+#define _TOU_SWAR_HIGHS (_TOU_SWAR_ONES << 7)
+#define _TOU_SWAR_HAS_ZERO(x) (((x) - _TOU_SWAR_ONES) & ~(x) & _TOU_SWAR_HIGHS)
+
+/* Word at a time, used when there's no SIMD */
+_TOU_NO_ASAN
+static const char* _tou_strchr_swar(const char* src, char c)
+{
+	for (; (uintptr_t)src % sizeof(size_t) != 0; src++) {
+		if (*src == c || *src == '\0')
+			return (*src == c) ? src : NULL;
+	}
+
+	const size_t rep = _TOU_SWAR_ONES * (unsigned char)c;
+	for (;; src += sizeof(size_t)) {
+		size_t w;
+		memcpy(&w, src, sizeof w);
+		if (_TOU_SWAR_HAS_ZERO(w) || _TOU_SWAR_HAS_ZERO(w ^ rep))
+			break;
+	}
+
+	for (; *src != c; src++) {
+		if (*src == '\0')
+			return NULL;
+	}
+	return src;
+}
+
+/*  */
+static const char* _tou_memrchr_scalar(const char* s, char c, size_t n)
+{
+	while (n-- > 0) {
+		if (s[n] == c)
+			return s + n;
+	}
+	return NULL;
+}
+
+#ifdef _TOU_SIMD_X86
+
+/*  */
+__attribute__((target("sse2"))) _TOU_NO_ASAN
+static const char* _tou_strchr_sse2(const char* src, char c)
+{
+	const __m128i vc = _mm_set1_epi8(c);
+	const __m128i vz = _mm_setzero_si128();
+	const size_t off = (uintptr_t)src & 15;
+	const char* p = src - off;
+
+	__m128i b = _mm_load_si128((const __m128i*)p);
+	unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, vc), _mm_cmpeq_epi8(b, vz))) >> off << off;
+
+	while (mask == 0) {
+		p += 16;
+		b = _mm_load_si128((const __m128i*)p);
+		mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, vc), _mm_cmpeq_epi8(b, vz)));
+	}
+
+	p += __builtin_ctz(mask);
+	return (*p == c) ? p : NULL;
+}
+
+/*  */
+__attribute__((target("avx2"))) _TOU_NO_ASAN
+static const char* _tou_strchr_avx2(const char* src, char c)
+{
+	const __m256i vc = _mm256_set1_epi8(c);
+	const __m256i vz = _mm256_setzero_si256();
+	const size_t off = (uintptr_t)src & 31;
+	const char* p = src - off;
+
+	__m256i b = _mm256_load_si256((const __m256i*)p);
+	unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(b, vc), _mm256_cmpeq_epi8(b, vz))) >> off << off;
+
+	while (mask == 0) {
+		p += 32;
+		b = _mm256_load_si256((const __m256i*)p);
+		mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(b, vc), _mm256_cmpeq_epi8(b, vz)));
+	}
+
+	p += __builtin_ctz(mask);
+	return (*p == c) ? p : NULL;
+}
+
+/*  */
+__attribute__((target("sse2")))
+static const char* _tou_memrchr_sse2(const char* s, char c, size_t n)
+{
+	const __m128i vc = _mm_set1_epi8(c);
+
+	while (n >= 16) {
+		n -= 16;
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + n)), vc));
+		if (mask)
+			return s + n + 31 - __builtin_clz(mask);
+	}
+	return _tou_memrchr_scalar(s, c, n);
+}
+
+/*  */
+__attribute__((target("avx2")))
+static const char* _tou_memrchr_avx2(const char* s, char c, size_t n)
+{
+	const __m256i vc = _mm256_set1_epi8(c);
+
+	while (n >= 32) {
+		n -= 32;
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(s + n)), vc));
+		if (mask)
+			return s + n + 31 - __builtin_clz(mask);
+	}
+	if (n >= 16) {
+		n -= 16;
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(s + n)), _mm256_castsi256_si128(vc)));
+		if (mask)
+			return s + n + 31 - __builtin_clz(mask);
+	}
+	_mm256_zeroupper();
+	return _tou_memrchr_scalar(s, c, n);
+}
+
+/* Mask of lanes holding one of the default TOU_IS_BLANK bytes */
+__attribute__((target("sse2")))
+static inline unsigned int _tou_blank_mask_sse2(__m128i b)
+{
+	__m128i m = _mm_or_si128(
+		_mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8(' ')),  _mm_cmpeq_epi8(b, _mm_set1_epi8('\t'))),
+		_mm_or_si128(_mm_cmpeq_epi8(b, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(b, _mm_set1_epi8('\r'))));
+	return (unsigned int)_mm_movemask_epi8(m);
+}
+
+/*  */
+__attribute__((target("avx2")))
+static inline unsigned int _tou_blank_mask_avx2(__m256i b)
+{
+	__m256i m = _mm256_or_si256(
+		_mm256_or_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8(' ')),  _mm256_cmpeq_epi8(b, _mm256_set1_epi8('\t'))),
+		_mm256_or_si256(_mm256_cmpeq_epi8(b, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(b, _mm256_set1_epi8('\r'))));
+	return (unsigned int)_mm256_movemask_epi8(m);
+}
+
+/* First non-blank byte; NUL isn't blank so it stops there */
+__attribute__((target("sse2"))) _TOU_NO_ASAN
+static const char* _tou_skip_blank_sse2(const char* src)
+{
+	const size_t off = (uintptr_t)src & 15;
+	const char* p = src - off;
+	unsigned int mask = ~_tou_blank_mask_sse2(_mm_load_si128((const __m128i*)p)) & 0xFFFFu & (0xFFFFu << off);
+
+	while (mask == 0) {
+		p += 16;
+		mask = ~_tou_blank_mask_sse2(_mm_load_si128((const __m128i*)p)) & 0xFFFFu;
+	}
+	return p + __builtin_ctz(mask);
+}
+
+/*  */
+__attribute__((target("avx2"))) _TOU_NO_ASAN
+static const char* _tou_skip_blank_avx2(const char* src)
+{
+	const size_t off = (uintptr_t)src & 31;
+	const char* p = src - off;
+	unsigned int mask = ~_tou_blank_mask_avx2(_mm256_load_si256((const __m256i*)p)) & (0xFFFFFFFFu << off);
+
+	while (mask == 0) {
+		p += 32;
+		mask = ~_tou_blank_mask_avx2(_mm256_load_si256((const __m256i*)p));
+	}
+	return p + __builtin_ctz(mask);
+}
+
+/* Length of `s` without its trailing blanks */
+__attribute__((target("sse2")))
+static size_t _tou_rskip_blank_sse2(const char* s, size_t n)
+{
+	while (n >= 16) {
+		unsigned int mask = ~_tou_blank_mask_sse2(_mm_loadu_si128((const __m128i*)(s + n - 16))) & 0xFFFFu;
+		if (mask)
+			return n - 16 + 32 - __builtin_clz(mask);
+		n -= 16;
+	}
+	while (n > 0 && TOU_IS_BLANK(s[n - 1]))
+		n--;
+	return n;
+}
+
+/*  */
+__attribute__((target("avx2")))
+static size_t _tou_rskip_blank_avx2(const char* s, size_t n)
+{
+	while (n >= 32) {
+		unsigned int mask = ~_tou_blank_mask_avx2(_mm256_loadu_si256((const __m256i*)(s + n - 32)));
+		if (mask)
+			return n - 32 + 32 - __builtin_clz(mask);
+		n -= 32;
+	}
+	if (n >= 16) {
+		unsigned int mask = ~_tou_blank_mask_sse2(_mm_loadu_si128((const __m128i*)(s + n - 16))) & 0xFFFFu;
+		if (mask)
+			return n - 16 + 32 - __builtin_clz(mask);
+		n -= 16;
+	}
+	while (n > 0 && TOU_IS_BLANK(s[n - 1]))
+		n--;
+	return n;
+}
+
+#endif
+
+
+/*  */
+static const char* _tou_skip_blank(const char* s)
+{
+	// Most strings start with no or just a few blanks
+	for (int i = 0; i < 4; i++, s++) {
+		if (!TOU_IS_BLANK(*s))
+			return s;
+	}
+
+#if defined(_TOU_SIMD_X86) && defined(_TOU_IS_BLANK_DEFAULT)
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX2)
+		return _tou_skip_blank_avx2(s);
+	if (features & _TOU_CPU_SSE2)
+		return _tou_skip_blank_sse2(s);
+#endif
+	while (*s != '\0' && TOU_IS_BLANK(*s))
+		s++;
+	return s;
+}
+
+
+/*  */
+static size_t _tou_rskip_blank(const char* s, size_t n)
+{
+	for (int i = 0; i < 4; i++, n--) {
+		if (n == 0 || !TOU_IS_BLANK(s[n - 1]))
+			return n;
+	}
+
+#if defined(_TOU_SIMD_X86) && defined(_TOU_IS_BLANK_DEFAULT)
+	int features = (n >= 16) ? _tou_cpu_features() : 0;
+	if (features & _TOU_CPU_AVX2)
+		return _tou_rskip_blank_avx2(s, n);
+	if (features & _TOU_CPU_SSE2)
+		return _tou_rskip_blank_sse2(s, n);
+#endif
+	while (n > 0 && TOU_IS_BLANK(s[n - 1]))
+		n--;
+	return n;
+}
+
+
+/*  */
+char* tou_strchr(const char* src, int ch)
+{
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX2)
+		return (char*)_tou_strchr_avx2(src, (char)ch);
+	if (features & _TOU_CPU_SSE2)
+		return (char*)_tou_strchr_sse2(src, (char)ch);
+#endif
+	return (char*)_tou_strchr_swar(src, (char)ch); // '\0' can also be searched for
+}
+
+
+/*  */
+char* tou_strrchr(const char* src, int ch)
+{
+	size_t len = strlen(src);
+
+	if ((char)ch == '\0') // '\0' can also be searched for
+		return (char*)src + len;
+
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX2)
+		return (char*)_tou_memrchr_avx2(src, (char)ch, len);
+	if (features & _TOU_CPU_SSE2)
+		return (char*)_tou_memrchr_sse2(src, (char)ch, len);
+#endif
+	return (char*)_tou_memrchr_scalar(src, (char)ch, len);
+}
+
+
+/*  */
+char* tou_trim_string(char** str)
+{
+	tou_trim_back(str);
+	return tou_trim_front(str);
+}
+
+
+/*  */
+char* tou_trim_front(char** str)
+{
+	if (str == NULL || *str == NULL)
+		return NULL;
+	
+	char* ptr = (char*)_tou_skip_blank(*str);
+	*str = ptr;
+	return ptr;
+}
+
+
+/*  */
+char* tou_trim_back(char** str)
+{
+	if (str == NULL || *str == NULL)
+		return NULL;
+
+	size_t len = strlen(*str);
+	size_t trimmed_len = _tou_rskip_blank(*str, len);
+	char* ptr = *str + trimmed_len;
+	memset(ptr, '\0', len - trimmed_len);
+	return ptr;
+}
+
+
+/*  */
+void tou_trim_string_pure(char* str, char** start, char** end)
+{
+	char* back = tou_trim_back_pure(str);
+	char* front = tou_trim_front_pure(str);
+
+	*end = back;
+	*start = front;
+}
+
+
+/*  */
+char* tou_trim_front_pure(char* str)
+{
+	if (str == NULL)
+		return NULL;
+
+	return (char*)_tou_skip_blank(str);
+}
+
+
+/*  */
+char* tou_trim_back_pure(char* str)
+{
+	if (str == NULL)
+		return NULL;
+
+	return str + _tou_rskip_blank(str, strlen(str)); // the first trimmed/NUL byte
+}
+
+
+/*
+	In-place byte mapping kernels; all of them work on exactly `n` bytes.
+
+	Case conversion flips bit 0x20 of bytes in [lo, hi] (ASCII letters of the
+	other case). Translation looks every byte up in a 256 entry table: AVX2
+	does it with 16 in-lane shuffles, one per table row, and keeps the lanes
+	whose high nibble selects that row; AVX-512 VBMI looks up 128 entries per
+	permute.
+*/
+
+/*  */
+static void _tou_flipcase_scalar(unsigned char* s, size_t n, unsigned char lo, unsigned char hi)
+{
+	for (size_t i = 0; i < n; i++) {
+		if ((unsigned char)(s[i] - lo) <= (unsigned char)(hi - lo))
+			s[i] ^= 0x20;
+	}
+}
+
+/*  */
+static void _tou_replace_ch_scalar(unsigned char* s, size_t n, unsigned char oldch, unsigned char newch)
+{
+	for (size_t i = 0; i < n; i++) {
+		if (s[i] == oldch)
+			s[i] = newch;
+	}
+}
+
+/*  */
+static void _tou_translate_scalar(unsigned char* s, size_t n, const unsigned char* table)
+{
+	for (size_t i = 0; i < n; i++)
+		s[i] = table[s[i]];
+}
+
+#ifdef _TOU_SIMD_X86
+
+/*  */
+__attribute__((target("sse2")))
+static void _tou_flipcase_sse2(unsigned char* s, size_t n, unsigned char lo, unsigned char hi)
+{
+	// Signed compares, so bytes >= 0x80 are never in range
+	const __m128i below = _mm_set1_epi8((char)(lo - 1));
+	const __m128i above = _mm_set1_epi8((char)(hi + 1));
+	const __m128i flip  = _mm_set1_epi8(0x20);
+	size_t i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i b = _mm_loadu_si128((const __m128i*)(s + i));
+		__m128i m = _mm_and_si128(_mm_cmpgt_epi8(b, below), _mm_cmplt_epi8(b, above));
+		_mm_storeu_si128((__m128i*)(s + i), _mm_xor_si128(b, _mm_and_si128(m, flip)));
+	}
+	_tou_flipcase_scalar(s + i, n - i, lo, hi);
+}
+
+/*  */
+__attribute__((target("avx2")))
+static void _tou_flipcase_avx2(unsigned char* s, size_t n, unsigned char lo, unsigned char hi)
+{
+	const __m256i below = _mm256_set1_epi8((char)(lo - 1));
+	const __m256i above = _mm256_set1_epi8((char)(hi + 1));
+	const __m256i flip  = _mm256_set1_epi8(0x20);
+	size_t i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i b = _mm256_loadu_si256((const __m256i*)(s + i));
+		__m256i m = _mm256_and_si256(_mm256_cmpgt_epi8(b, below), _mm256_cmpgt_epi8(above, b));
+		_mm256_storeu_si256((__m256i*)(s + i), _mm256_xor_si256(b, _mm256_and_si256(m, flip)));
+	}
+	_mm256_zeroupper();
+	_tou_flipcase_scalar(s + i, n - i, lo, hi);
+}
+
+/*  */
+__attribute__((target("sse2")))
+static void _tou_replace_ch_sse2(unsigned char* s, size_t n, unsigned char oldch, unsigned char newch)
+{
+	const __m128i vold = _mm_set1_epi8((char)oldch);
+	const __m128i diff = _mm_set1_epi8((char)(oldch ^ newch));
+	size_t i = 0;
+
+	for (; i + 16 <= n; i += 16) {
+		__m128i b = _mm_loadu_si128((const __m128i*)(s + i));
+		__m128i m = _mm_cmpeq_epi8(b, vold);
+		_mm_storeu_si128((__m128i*)(s + i), _mm_xor_si128(b, _mm_and_si128(m, diff)));
+	}
+	_tou_replace_ch_scalar(s + i, n - i, oldch, newch);
+}
+
+/*  */
+__attribute__((target("avx2")))
+static void _tou_replace_ch_avx2(unsigned char* s, size_t n, unsigned char oldch, unsigned char newch)
+{
+	const __m256i vold = _mm256_set1_epi8((char)oldch);
+	const __m256i diff = _mm256_set1_epi8((char)(oldch ^ newch));
+	size_t i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i b = _mm256_loadu_si256((const __m256i*)(s + i));
+		__m256i m = _mm256_cmpeq_epi8(b, vold);
+		_mm256_storeu_si256((__m256i*)(s + i), _mm256_xor_si256(b, _mm256_and_si256(m, diff)));
+	}
+	_mm256_zeroupper();
+	_tou_replace_ch_scalar(s + i, n - i, oldch, newch);
+}
+
+/*  */
+__attribute__((target("avx2")))
+static void _tou_translate_avx2(unsigned char* s, size_t n, const unsigned char* table)
+{
+	__m256i rows[16];
+	for (int r = 0; r < 16; r++)
+		rows[r] = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(table + 16 * r)));
+
+	const __m256i nibble = _mm256_set1_epi8(0x0F);
+	size_t i = 0;
+
+	for (; i + 32 <= n; i += 32) {
+		__m256i b  = _mm256_loadu_si256((const __m256i*)(s + i));
+		__m256i lo = _mm256_and_si256(b, nibble);
+		__m256i hi = _mm256_and_si256(_mm256_srli_epi16(b, 4), nibble);
+		__m256i res = _mm256_setzero_si256();
+
+		for (int r = 0; r < 16; r++) {
+			__m256i sel = _mm256_cmpeq_epi8(hi, _mm256_set1_epi8((char)r));
+			res = _mm256_or_si256(res, _mm256_and_si256(sel, _mm256_shuffle_epi8(rows[r], lo)));
+		}
+		_mm256_storeu_si256((__m256i*)(s + i), res);
+	}
+	_mm256_zeroupper();
+	_tou_translate_scalar(s + i, n - i, table);
+}
+
+/*  */
+__attribute__((target("avx512f,avx512bw,avx512vbmi")))
+static void _tou_translate_avx512vbmi(unsigned char* s, size_t n, const unsigned char* table)
+{
+	const __m512i t0 = _mm512_loadu_si512((const void*)(table));
+	const __m512i t1 = _mm512_loadu_si512((const void*)(table + 64));
+	const __m512i t2 = _mm512_loadu_si512((const void*)(table + 128));
+	const __m512i t3 = _mm512_loadu_si512((const void*)(table + 192));
+	size_t i = 0;
+
+	for (; i + 64 <= n; i += 64) {
+		__m512i b = _mm512_loadu_si512((const void*)(s + i));
+		__m512i lo_half = _mm512_permutex2var_epi8(t0, b, t1); // uses the low 7 bits of `b`
+		__m512i hi_half = _mm512_permutex2var_epi8(t2, b, t3);
+		__m512i res = _mm512_mask_blend_epi8(_mm512_movepi8_mask(b), lo_half, hi_half);
+		_mm512_storeu_si512((void*)(s + i), res);
+	}
+	_mm256_zeroupper();
+	_tou_translate_scalar(s + i, n - i, table);
+}
+
+#endif
+
+
+/*  */
+static void _tou_flipcase(char* str, size_t n, unsigned char lo, unsigned char hi)
+{
+	unsigned char* s = (unsigned char*)str;
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX2)
+		_tou_flipcase_avx2(s, n, lo, hi);
+	else if (features & _TOU_CPU_SSE2)
+		_tou_flipcase_sse2(s, n, lo, hi);
+	else
+#endif
+		_tou_flipcase_scalar(s, n, lo, hi);
+}
+
+
+/*  */
+char* tou_slower(char* str)
+{
+	if (!str)
+		return NULL;
+
+	_tou_flipcase(str, strlen(str), 'A', 'Z');
+	return str;
+}
+
+/*  */
+char* tou_supper(char* str)
+{
+	if (!str)
+		return NULL;
+
+	_tou_flipcase(str, strlen(str), 'a', 'z');
+	return str;
+}
+
+
+/*  */
+char* tou_replace_ch(char* ss, char oldch, char newch)
+{
+	if (!ss)
+		return NULL;
+
+	TOU_PRINTD("[replace_ch] replacing ('%c'->'%c') \"%s\" => ", oldch, newch, ss);
+	unsigned char* s = (unsigned char*)ss;
+	size_t n = strlen(ss);
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX2)
+		_tou_replace_ch_avx2(s, n, oldch, newch);
+	else if (features & _TOU_CPU_SSE2)
+		_tou_replace_ch_sse2(s, n, oldch, newch);
+	else
+#endif
+		_tou_replace_ch_scalar(s, n, oldch, newch);
+	TOU_PRINTD("\"%s\"\n", ss);
+	return ss;
+}
+
+
+/*  */
+char* tou_stranslate(char* str, size_t len, const unsigned char table[256])
+{
+	if (!str || !table)
+		return NULL;
+
+	unsigned char* s = (unsigned char*)str;
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX512VBMI)
+		_tou_translate_avx512vbmi(s, len, table);
+	else if (features & _TOU_CPU_AVX2)
+		_tou_translate_avx2(s, len, table);
+	else
+#endif
+		_tou_translate_scalar(s, len, table);
+	return str;
+}
+
+
+/*  */
+char* tou_sfind(const char* src, const char* kwd)
+{
+	return tou_sfind_n(src, kwd, strlen(src));
+}
+
+
+/*
+	Two-Way string matching (Crochemore-Perrin), see:
+	http://www-igm.univ-mlv.fr/~lecroq/string/node26.html
+
+	Keyword is split at its critical factorization into a left and right
+	half; the right half is matched left-to-right and the left half
+	right-to-left, which together with the period gives a shift that
+	never backtracks in the haystack -> O(n + m) time, O(1) space.
+*/
+typedef struct {
+	size_t ms;   /* position before the critical factorization (may wrap to (size_t)-1) */
+	size_t p;    /* period of the keyword (or a safe shift if non-periodic) */
+	size_t mem0; /* how much of the keyword is known to match after a full-period shift */
+} _tou_twoway_t;
+
+
+/*  */
+static void _tou_twoway_prep(const unsigned char* n, size_t l, _tou_twoway_t* tw)
+{
+	size_t ip, jp, k, p, ms, p0;
+
+	// Compute maximal suffix
+	ip = (size_t)-1; jp = 0; k = p = 1;
+	while (jp + k < l) {
+		if (n[ip + k] == n[jp + k]) {
+			if (k == p) { jp += p; k = 1; }
+			else k++;
+		} else if (n[ip + k] > n[jp + k]) {
+			jp += k; k = 1; p = jp - ip;
+		} else {
+			ip = jp++; k = p = 1;
+		}
+	}
+	ms = ip;
+	p0 = p;
+
+	// And with the opposite comparison
+	ip = (size_t)-1; jp = 0; k = p = 1;
+	while (jp + k < l) {
+		if (n[ip + k] == n[jp + k]) {
+			if (k == p) { jp += p; k = 1; }
+			else k++;
+		} else if (n[ip + k] < n[jp + k]) {
+			jp += k; k = 1; p = jp - ip;
+		} else {
+			ip = jp++; k = p = 1;
+		}
+	}
+	if (ip + 1 > ms + 1) ms = ip;
+	else p = p0;
+
+	// Periodic keyword?
+	if (memcmp(n, n + p, ms + 1) != 0) {
+		tw->mem0 = 0;
+		p = ((ms > l - ms - 1) ? ms : (l - ms - 1)) + 1;
+	} else {
+		tw->mem0 = l - p;
+	}
+
+	tw->ms = ms;
+	tw->p = p;
+}
+
+
+/* `shift` is an optional Horspool table (see ::tou_pattern), NULL to search in O(1) space */
+static const char* _tou_twoway_search(const unsigned char* h, size_t hl, const unsigned char* n, size_t l, const _tou_twoway_t* tw, const size_t* shift)
+{
+	const unsigned char* end = h + hl;
+	const size_t ms = tw->ms;
+	size_t mem = 0;
+	size_t k;
+
+	while ((size_t)(end - h) >= l) {
+		// Skip ahead by the last byte of the window first
+		if (shift && (k = shift[h[l - 1]]) != 0) {
+			if (k < mem) k = mem;
+			h += k;
+			mem = 0;
+			continue;
+		}
+		// Compare right half
+		for (k = (ms + 1 > mem) ? ms + 1 : mem; k < l && n[k] == h[k]; k++) ;
+		if (k < l) {
+			h += k - ms;
+			mem = 0;
+			continue;
+		}
+		// Compare left half
+		for (k = ms + 1; k > mem && n[k - 1] == h[k - 1]; k--) ;
+		if (k <= mem)
+			return (const char*)h;
+		h += tw->p;
+		mem = tw->mem0;
+	}
+
+	return NULL;
+}
+
+
+/*
+	Substring search kernels. All of them expect 2 <= l <= hl.
+
+	SIMD kernels compare the first and the last byte of the keyword against
+	16/32/64 haystack positions at once and only verify the candidates.
+	Verification work is tracked and once it exceeds the scanned length
+	(plus some slack) the rest is handed to Two-Way, so the worst case
+	stays linear.
+*/
+typedef const char* (*_tou_sfind_kernel_t)(const unsigned char* h, size_t hl, const unsigned char* n, size_t l);
+
+#define _TOU_SFIND_WORK_SLACK 4096
+
+/*  */
+static const char* _tou_sfind_scalar(const unsigned char* h, size_t hl, const unsigned char* n, size_t l)
+{
+	_tou_twoway_t tw;
+	_tou_twoway_prep(n, l, &tw);
+	return _tou_twoway_search(h, hl, n, l, &tw, NULL);
+}
+
+#ifdef _TOU_SIMD_X86
+
+/*  */
+__attribute__((target("sse2")))
+static const char* _tou_sfind_sse2(const unsigned char* h, size_t hl, const unsigned char* n, size_t l)
+{
+	const __m128i first = _mm_set1_epi8((char)n[0]);
+	const __m128i last  = _mm_set1_epi8((char)n[l - 1]);
+	size_t i = 0, work = 0;
+
+	for (; i + 16 + l - 1 <= hl; i += 16) {
+		__m128i bf = _mm_loadu_si128((const __m128i*)(h + i));
+		__m128i bl = _mm_loadu_si128((const __m128i*)(h + i + l - 1));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(
+			_mm_and_si128(_mm_cmpeq_epi8(first, bf), _mm_cmpeq_epi8(last, bl)));
+
+		while (mask) {
+			size_t pos = i + __builtin_ctz(mask);
+			if (memcmp(h + pos + 1, n + 1, l - 2) == 0)
+				return (const char*)(h + pos);
+			work += l;
+			mask &= mask - 1;
+		}
+		if (work > i + _TOU_SFIND_WORK_SLACK)
+			break;
+	}
+
+	return _tou_sfind_scalar(h + i, hl - i, n, l);
+}
+
+/*  */
+__attribute__((target("avx2")))
+static const char* _tou_sfind_avx2(const unsigned char* h, size_t hl, const unsigned char* n, size_t l)
+{
+	const __m256i first = _mm256_set1_epi8((char)n[0]);
+	const __m256i last  = _mm256_set1_epi8((char)n[l - 1]);
+	size_t i = 0, work = 0;
+
+	for (; i + 32 + l - 1 <= hl; i += 32) {
+		__m256i bf = _mm256_loadu_si256((const __m256i*)(h + i));
+		__m256i bl = _mm256_loadu_si256((const __m256i*)(h + i + l - 1));
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+			_mm256_and_si256(_mm256_cmpeq_epi8(first, bf), _mm256_cmpeq_epi8(last, bl)));
+
+		while (mask) {
+			size_t pos = i + __builtin_ctz(mask);
+			if (memcmp(h + pos + 1, n + 1, l - 2) == 0)
+				return (const char*)(h + pos);
+			work += l;
+			mask &= mask - 1;
+		}
+		if (work > i + _TOU_SFIND_WORK_SLACK)
+			break;
+	}
+
+	_mm256_zeroupper(); // the scalar fallback may run legacy SSE code
+	return _tou_sfind_scalar(h + i, hl - i, n, l);
+}
+
+/*  */
+__attribute__((target("avx512f,avx512bw")))
+static const char* _tou_sfind_avx512(const unsigned char* h, size_t hl, const unsigned char* n, size_t l)
+{
+	const __m512i first = _mm512_set1_epi8((char)n[0]);
+	const __m512i last  = _mm512_set1_epi8((char)n[l - 1]);
+	size_t i = 0, work = 0;
+
+	for (; i + 64 + l - 1 <= hl; i += 64) {
+		__m512i bf = _mm512_loadu_si512((const void*)(h + i));
+		__m512i bl = _mm512_loadu_si512((const void*)(h + i + l - 1));
+		unsigned long long mask = (unsigned long long)(
+			_mm512_cmpeq_epi8_mask(first, bf) & _mm512_cmpeq_epi8_mask(last, bl));
+
+		while (mask) {
+			size_t pos = i + __builtin_ctzll(mask);
+			if (memcmp(h + pos + 1, n + 1, l - 2) == 0)
+				return (const char*)(h + pos);
+			work += l;
+			mask &= mask - 1;
+		}
+		if (work > i + _TOU_SFIND_WORK_SLACK)
+			break;
+	}
+
+	_mm256_zeroupper(); // the scalar fallback may run legacy SSE code
+	return _tou_sfind_scalar(h + i, hl - i, n, l);
+}
+
+#endif
+
+static const char* _tou_sfind_select(const unsigned char* h, size_t hl, const unsigned char* n, size_t l);
+
+/* Points to the selector until the first search, then to the chosen kernel */
+static _tou_sfind_kernel_t _tou_g_sfind_kernel = _tou_sfind_select;
+
+/*  */
+static _tou_sfind_kernel_t _tou_sfind_pick(void)
+{
+	_tou_sfind_kernel_t kernel = _tou_sfind_scalar;
+
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX512BW)
+		kernel = _tou_sfind_avx512;
+	else if (features & _TOU_CPU_AVX2)
+		kernel = _tou_sfind_avx2;
+	else if (features & _TOU_CPU_SSE2)
+		kernel = _tou_sfind_sse2;
+#endif
+
+	return kernel;
+}
+
+/*  */
+static const char* _tou_sfind_select(const unsigned char* h, size_t hl, const unsigned char* n, size_t l)
+{
+	_tou_sfind_kernel_t kernel = _tou_sfind_pick();
+	_TOU_STORE_RELAXED(&_tou_g_sfind_kernel, kernel);
+	return kernel(h, hl, n, l);
+}
+
+
+/* Keywords at least this long skip through the haystack faster than SIMD filtering */
+#define _TOU_PAT_SKIP_MIN_LEN 64
+
+/*
+	Finds `kwd` (of length `kl`) in exactly `hl` bytes of `h`, through
+	`pat` if one is given.
+*/
+static char* _tou_find(const char* h, size_t hl, const char* kwd, size_t kl, const tou_pattern* pat)
+{
+	if (kl > hl)
+		return NULL;
+	if (kl == 0)
+		return (char*)h;
+	if (kl == 1)
+		return memchr(h, *kwd, hl);
+
+	if (pat && (kl >= _TOU_PAT_SKIP_MIN_LEN || !(_tou_cpu_features() & _TOU_CPU_SSE2))) {
+		_tou_twoway_t tw = {pat->tw_ms, pat->tw_p, pat->tw_mem0};
+		return (char*)_tou_twoway_search((const unsigned char*)h, hl, (const unsigned char*)kwd, kl, &tw, pat->shift);
+	}
+
+	return (char*)_TOU_LOAD_RELAXED(&_tou_g_sfind_kernel)((const unsigned char*)h, hl, (const unsigned char*)kwd, kl);
+}
+
+
+/*
+	Iterates over all non-overlapping matches from left to right.
+
+	Calling _tou_find in a loop starts a new search after every match, which
+	is what dominates when matches are dense. The finder keeps the candidate
+	mask of the current block instead, so each further match costs a bit scan
+	and a short memcmp. Like the kernels it hands over to _tou_find once
+	verification stops paying off, and for the tail that doesn't fill a block.
+*/
+typedef uint64_t (*_tou_cand_fn_t)(const unsigned char* h, size_t* at, size_t last, const unsigned char* n, size_t l);
+
+typedef struct {
+	const char* h;
+	size_t hl;
+	const char* kwd;
+	size_t kl;
+	const tou_pattern* pat;
+	size_t pos;          // the next match can't start before this
+	size_t next;         // start of the next block to filter; everything before it was filtered
+	size_t block;        // start of the block `mask` belongs to
+	uint64_t mask;       // candidates left in that block
+	size_t work;         // bytes compared for rejected candidates
+	_tou_cand_fn_t cand; // block filter, NULL when searching with _tou_find only
+	size_t width;        // bytes per block
+} _tou_finder_t;
+
+#ifdef _TOU_SIMD_X86
+
+/*
+	Filters blocks from `*at` on (while they start at or before `last`) and
+	returns the mask of positions where both the first and the last byte of
+	`n` match, for the first block that has any. `*at` is left at that block.
+*/
+__attribute__((target("sse2")))
+static uint64_t _tou_cand_sse2(const unsigned char* h, size_t* at, size_t last, const unsigned char* n, size_t l)
+{
+	const __m128i first = _mm_set1_epi8((char)n[0]);
+	const __m128i lastb = _mm_set1_epi8((char)n[l - 1]);
+	size_t i = *at;
+	unsigned int mask = 0;
+
+	for (; i <= last; i += 16) {
+		__m128i bf = _mm_loadu_si128((const __m128i*)(h + i));
+		__m128i bl = _mm_loadu_si128((const __m128i*)(h + i + l - 1));
+		mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bf, first), _mm_cmpeq_epi8(bl, lastb)));
+		if (mask)
+			break;
+	}
+	*at = i;
+	return mask;
+}
+
+/*  */
+__attribute__((target("avx2")))
+static uint64_t _tou_cand_avx2(const unsigned char* h, size_t* at, size_t last, const unsigned char* n, size_t l)
+{
+	const __m256i first = _mm256_set1_epi8((char)n[0]);
+	const __m256i lastb = _mm256_set1_epi8((char)n[l - 1]);
+	size_t i = *at;
+	unsigned int mask = 0;
+
+	for (; i <= last; i += 32) {
+		__m256i bf = _mm256_loadu_si256((const __m256i*)(h + i));
+		__m256i bl = _mm256_loadu_si256((const __m256i*)(h + i + l - 1));
+		mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(bf, first), _mm256_cmpeq_epi8(bl, lastb)));
+		if (mask)
+			break;
+	}
+	*at = i;
+	return mask;
+}
+
+/*  */
+__attribute__((target("avx512f,avx512bw")))
+static uint64_t _tou_cand_avx512(const unsigned char* h, size_t* at, size_t last, const unsigned char* n, size_t l)
+{
+	const __m512i first = _mm512_set1_epi8((char)n[0]);
+	const __m512i lastb = _mm512_set1_epi8((char)n[l - 1]);
+	size_t i = *at;
+	uint64_t mask = 0;
+
+	for (; i <= last; i += 64) {
+		__m512i bf = _mm512_loadu_si512((const void*)(h + i));
+		__m512i bl = _mm512_loadu_si512((const void*)(h + i + l - 1));
+		mask = _mm512_cmpeq_epi8_mask(bf, first) & _mm512_cmpeq_epi8_mask(bl, lastb);
+		if (mask)
+			break;
+	}
+	*at = i;
+	return mask;
+}
+
+#endif
+
+
+/*  */
+static void _tou_finder_init(_tou_finder_t* f, const char* h, size_t hl, const char* kwd, size_t kl, const tou_pattern* pat)
+{
+	f->h = h;
+	f->hl = hl;
+	f->kwd = kwd;
+	f->kl = kl;
+	f->pat = pat;
+	f->pos = 0;
+	f->next = 0;
+	f->block = 0;
+	f->mask = 0;
+	f->work = 0;
+	f->cand = NULL;
+	f->width = 0;
+
+#ifdef _TOU_SIMD_X86
+	// Long compiled patterns skip ahead faster on their own
+	if (kl > 0 && !(pat && kl >= _TOU_PAT_SKIP_MIN_LEN)) {
+		int features = _tou_cpu_features();
+		if (features & _TOU_CPU_AVX512BW) {
+			f->cand = _tou_cand_avx512;
+			f->width = 64;
+		} else if (features & _TOU_CPU_AVX2) {
+			f->cand = _tou_cand_avx2;
+			f->width = 32;
+		} else if (features & _TOU_CPU_SSE2) {
+			f->cand = _tou_cand_sse2;
+			f->width = 16;
+		}
+	}
+#endif
+}
+
+
+/* Returns the next match or NULL; an empty keyword never matches */
+static const char* _tou_finder_next(_tou_finder_t* f)
+{
+	if (f->kl == 0 || f->pos > f->hl)
+		return NULL;
+
+	const unsigned char* h = (const unsigned char*)f->h;
+	const unsigned char* n = (const unsigned char*)f->kwd;
+
+	while (f->cand) {
+		while (f->mask) {
+			size_t c = f->block + __builtin_ctzll(f->mask);
+			f->mask &= f->mask - 1;
+			if (c < f->pos)
+				continue; // overlaps the previous match
+
+			if (f->kl <= 2 || memcmp(h + c + 1, n + 1, f->kl - 2) == 0) {
+				f->pos = c + f->kl;
+				return f->h + c;
+			}
+			f->work += f->kl;
+		}
+
+		if (f->next < f->pos)
+			f->next = f->pos;
+		if (f->next + f->width + f->kl - 1 > f->hl || f->work > f->next + _TOU_SFIND_WORK_SLACK) {
+			f->cand = NULL;
+			break;
+		}
+		f->block = f->next;
+		f->mask = f->cand(h, &f->block, f->hl - f->width - f->kl + 1, n, f->kl);
+		// Without candidates the filter stopped at the first block it didn't look at
+		f->next = f->mask ? f->block + f->width : f->block;
+	}
+
+	// Blocks the filter already went through hold no further match
+	size_t from = (f->next > f->pos) ? f->next : f->pos;
+	const char* found = _tou_find(f->h + from, f->hl - from, f->kwd, f->kl, f->pat);
+	if (found == NULL) {
+		f->pos = f->hl + 1;
+		return NULL;
+	}
+	f->pos = (found - f->h) + f->kl;
+	return found;
+}
+
+
+/*
+	Bulk indexing of a single delimiter byte, the way structural indexers
+	(simdjson) do it: 64 bytes are compared at a time, the result becomes a
+	bitmask and every set bit is written out as an offset with a bit scan.
+	Splitting on one byte then walks an array of offsets instead of searching
+	again after every token.
+
+	Kernels fill `offs` from whole 64-byte blocks starting at `*at`, while a
+	whole block fits before `end` and its offsets fit in `max`, advance `*at`
+	and return the count written.
+*/
+typedef size_t (*_tou_index_kernel_t)(const unsigned char* h, size_t* at, size_t end, unsigned char c, size_t* offs, size_t max);
+
+#define _TOU_INDEX_BLOCK 64
+
+/* Writes the offsets of the set bits in `mask` (of the block at `base`) */
+#define _TOU_INDEX_FLATTEN(mask, base, offs, n) do { \
+	uint64_t _m = (mask); \
+	while (_m) { \
+		(offs)[(n)++] = (base) + __builtin_ctzll(_m); \
+		_m &= _m - 1; \
+	} \
+} while (0)
+
+/*  */
+static size_t _tou_index_byte_scalar(const unsigned char* h, size_t* at, size_t end, unsigned char c, size_t* offs, size_t max)
+{
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		for (size_t j = 0; j < _TOU_INDEX_BLOCK; j++) {
+			offs[n] = i + j;
+			n += (h[i + j] == c); // branchless: the slot is overwritten unless it matched
+		}
+	}
+	*at = i;
+	return n;
+}
+
+#ifdef _TOU_SIMD_X86
+
+/*  */
+__attribute__((target("sse2")))
+static size_t _tou_index_byte_sse2(const unsigned char* h, size_t* at, size_t end, unsigned char c, size_t* offs, size_t max)
+{
+	const __m128i cv = _mm_set1_epi8((char)c);
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		uint64_t m0 = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + i)), cv));
+		uint64_t m1 = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + i + 16)), cv));
+		uint64_t m2 = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + i + 32)), cv));
+		uint64_t m3 = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(h + i + 48)), cv));
+		_TOU_INDEX_FLATTEN(m0 | (m1 << 16) | (m2 << 32) | (m3 << 48), i, offs, n);
+	}
+	*at = i;
+	return n;
+}
+
+/*  */
+__attribute__((target("avx2")))
+static size_t _tou_index_byte_avx2(const unsigned char* h, size_t* at, size_t end, unsigned char c, size_t* offs, size_t max)
+{
+	const __m256i cv = _mm256_set1_epi8((char)c);
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		uint64_t lo = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i)), cv));
+		uint64_t hi = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(h + i + 32)), cv));
+		_TOU_INDEX_FLATTEN(lo | (hi << 32), i, offs, n);
+	}
+	*at = i;
+	_mm256_zeroupper();
+	return n;
+}
+
+/*  */
+__attribute__((target("avx512bw")))
+static size_t _tou_index_byte_avx512(const unsigned char* h, size_t* at, size_t end, unsigned char c, size_t* offs, size_t max)
+{
+	const __m512i cv = _mm512_set1_epi8((char)c);
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		uint64_t mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*)(h + i)), cv);
+		_TOU_INDEX_FLATTEN(mask, i, offs, n);
+	}
+	*at = i;
+	_mm256_zeroupper();
+	return n;
+}
+
+#endif
+
+static size_t _tou_index_byte_select(const unsigned char* h, size_t* at, size_t end, unsigned char c, size_t* offs, size_t max);
+
+/* Points to the selector until the first use, then to the chosen kernel */
+static _tou_index_kernel_t _tou_g_index_kernel = _tou_index_byte_select;
+
+/*  */
+static _tou_index_kernel_t _tou_index_byte_pick(void)
+{
+	_tou_index_kernel_t kernel = _tou_index_byte_scalar;
+
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX512BW)
+		kernel = _tou_index_byte_avx512;
+	else if (features & _TOU_CPU_AVX2)
+		kernel = _tou_index_byte_avx2;
+	else if (features & _TOU_CPU_SSE2)
+		kernel = _tou_index_byte_sse2;
+#endif
+
+	return kernel;
+}
+
+/*  */
+static size_t _tou_index_byte_select(const unsigned char* h, size_t* at, size_t end, unsigned char c, size_t* offs, size_t max)
+{
+	_tou_index_kernel_t kernel = _tou_index_byte_pick();
+	_TOU_STORE_RELAXED(&_tou_g_index_kernel, kernel);
+	return kernel(h, at, end, c, offs, max);
+}
+
+
+/* Offsets are indexed this many at a time */
+#define _TOU_INDEX_BATCH 256
+
+/*
+	Fills `offs` (of _TOU_INDEX_BATCH elements) with the next positions of
+	`c` in `h` from `*at` on and returns how many; `*at` reaching `hl` means
+	the whole buffer has been indexed.
+*/
+static size_t _tou_index_byte(const char* h, size_t hl, size_t* at, char c, size_t* offs)
+{
+	size_t n = _TOU_LOAD_RELAXED(&_tou_g_index_kernel)((const unsigned char*)h, at, hl, (unsigned char)c, offs, _TOU_INDEX_BATCH);
+
+	if (*at + _TOU_INDEX_BLOCK > hl && n + _TOU_INDEX_BLOCK <= _TOU_INDEX_BATCH) {
+		// Less than a block left, it fits in the rest of the batch
+		for (size_t i = *at; i < hl; i++) {
+			if (h[i] == c)
+				offs[n++] = i;
+		}
+		*at = hl;
+	}
+	return n;
+}
+
+
+/*
+	CSV separators are indexed the same way, but only outside of quotes.
+	A prefix XOR over the quote mask gives the bytes between an opening and
+	a closing quote (a doubled quote toggles twice, so it stays inside), and
+	`*in_quotes` carries that state over to the next block.
+*/
+typedef size_t (*_tou_csv_index_kernel_t)(const unsigned char* h, size_t* at, size_t end, unsigned char delim, unsigned char quote,
+	uint64_t* in_quotes, size_t* offs, size_t max);
+
+/* Appends the offsets of separators (delimiters and newlines) outside of quotes */
+static inline void _tou_csv_flatten(uint64_t seps, uint64_t quotes, uint64_t* in_quotes, size_t base, size_t* offs, size_t* n)
+{
+	uint64_t inside = quotes;
+	inside ^= inside << 1;
+	inside ^= inside << 2;
+	inside ^= inside << 4;
+	inside ^= inside << 8;
+	inside ^= inside << 16;
+	inside ^= inside << 32;
+	inside ^= *in_quotes;
+	*in_quotes = (uint64_t)0 - (inside >> 63);
+
+	size_t k = *n;
+	_TOU_INDEX_FLATTEN(seps & ~inside, base, offs, k);
+	*n = k;
+}
+
+/* Classifies up to a block of bytes one by one */
+static void _tou_csv_masks_scalar(const unsigned char* p, size_t len, unsigned char delim, unsigned char quote, uint64_t* seps, uint64_t* quotes)
+{
+	uint64_t s = 0, q = 0;
+	for (size_t j = 0; j < len; j++) {
+		s |= (uint64_t)(p[j] == delim || p[j] == '\n') << j;
+		q |= (uint64_t)(quote && p[j] == quote) << j;
+	}
+	*seps = s;
+	*quotes = q;
+}
+
+/* Byte by byte, tracking the quote state directly */
+static size_t _tou_csv_index_scalar(const unsigned char* h, size_t* at, size_t end, unsigned char delim, unsigned char quote,
+	uint64_t* in_quotes, size_t* offs, size_t max)
+{
+	const unsigned int qon = (quote != 0);
+	unsigned int inside = (unsigned int)(*in_quotes & 1);
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		for (size_t j = i; j < i + _TOU_INDEX_BLOCK; j++) {
+			const unsigned char c = h[j];
+			inside ^= (c == quote) & qon;
+			offs[n] = j;
+			n += ((c == delim) | (c == '\n')) & (inside ^ 1); // branchless, the slot is reused otherwise
+		}
+	}
+	*at = i;
+	*in_quotes = (uint64_t)0 - inside;
+	return n;
+}
+
+#ifdef _TOU_SIMD_X86
+
+/*  */
+__attribute__((target("sse2")))
+static size_t _tou_csv_index_sse2(const unsigned char* h, size_t* at, size_t end, unsigned char delim, unsigned char quote,
+	uint64_t* in_quotes, size_t* offs, size_t max)
+{
+	const __m128i dv = _mm_set1_epi8((char)delim);
+	const __m128i nv = _mm_set1_epi8('\n');
+	const __m128i qv = _mm_set1_epi8((char)quote);
+	const uint64_t qon = quote ? ~(uint64_t)0 : 0;
+	uint64_t inside = *in_quotes; // kept out of memory, `offs` stores could alias it
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		uint64_t seps = 0, quotes = 0;
+		for (int k = 0; k < 4; k++) {
+			__m128i b = _mm_loadu_si128((const __m128i*)(h + i + 16 * k));
+			seps |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(b, dv), _mm_cmpeq_epi8(b, nv))) << (16 * k);
+			quotes |= (uint64_t)(unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(b, qv)) << (16 * k);
+		}
+		_tou_csv_flatten(seps, quotes & qon, &inside, i, offs, &n);
+	}
+	*at = i;
+	*in_quotes = inside;
+	return n;
+}
+
+/*  */
+__attribute__((target("avx2")))
+static size_t _tou_csv_index_avx2(const unsigned char* h, size_t* at, size_t end, unsigned char delim, unsigned char quote,
+	uint64_t* in_quotes, size_t* offs, size_t max)
+{
+	const __m256i dv = _mm256_set1_epi8((char)delim);
+	const __m256i nv = _mm256_set1_epi8('\n');
+	const __m256i qv = _mm256_set1_epi8((char)quote);
+	const uint64_t qon = quote ? ~(uint64_t)0 : 0;
+	uint64_t inside = *in_quotes; // kept out of memory, `offs` stores could alias it
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		__m256i lo = _mm256_loadu_si256((const __m256i*)(h + i));
+		__m256i hi = _mm256_loadu_si256((const __m256i*)(h + i + 32));
+		uint64_t seps = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(lo, dv), _mm256_cmpeq_epi8(lo, nv)))
+			| (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(hi, dv), _mm256_cmpeq_epi8(hi, nv))) << 32;
+		uint64_t quotes = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, qv))
+			| (uint64_t)(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, qv)) << 32;
+		_tou_csv_flatten(seps, quotes & qon, &inside, i, offs, &n);
+	}
+	*at = i;
+	*in_quotes = inside;
+	_mm256_zeroupper();
+	return n;
+}
+
+/*  */
+__attribute__((target("avx512bw")))
+static size_t _tou_csv_index_avx512(const unsigned char* h, size_t* at, size_t end, unsigned char delim, unsigned char quote,
+	uint64_t* in_quotes, size_t* offs, size_t max)
+{
+	const __m512i dv = _mm512_set1_epi8((char)delim);
+	const __m512i nv = _mm512_set1_epi8('\n');
+	const __m512i qv = _mm512_set1_epi8((char)quote);
+	const uint64_t qon = quote ? ~(uint64_t)0 : 0;
+	uint64_t inside = *in_quotes; // kept out of memory, `offs` stores could alias it
+	size_t i = *at, n = 0;
+
+	for (; i + _TOU_INDEX_BLOCK <= end && n + _TOU_INDEX_BLOCK <= max; i += _TOU_INDEX_BLOCK) {
+		__m512i b = _mm512_loadu_si512((const void*)(h + i));
+		uint64_t seps = _mm512_cmpeq_epi8_mask(b, dv) | _mm512_cmpeq_epi8_mask(b, nv);
+		uint64_t quotes = _mm512_cmpeq_epi8_mask(b, qv);
+		_tou_csv_flatten(seps, quotes & qon, &inside, i, offs, &n);
+	}
+	*at = i;
+	*in_quotes = inside;
+	_mm256_zeroupper();
+	return n;
+}
+
+#endif
+
+static size_t _tou_csv_index_select(const unsigned char* h, size_t* at, size_t end, unsigned char delim, unsigned char quote,
+	uint64_t* in_quotes, size_t* offs, size_t max);
+
+/* Points to the selector until the first use, then to the chosen kernel */
+static _tou_csv_index_kernel_t _tou_g_csv_index_kernel = _tou_csv_index_select;
+
+/*  */
+static _tou_csv_index_kernel_t _tou_csv_index_pick(void)
+{
+	_tou_csv_index_kernel_t kernel = _tou_csv_index_scalar;
+
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX512BW)
+		kernel = _tou_csv_index_avx512;
+	else if (features & _TOU_CPU_AVX2)
+		kernel = _tou_csv_index_avx2;
+	else if (features & _TOU_CPU_SSE2)
+		kernel = _tou_csv_index_sse2;
+#endif
+
+	return kernel;
+}
+
+/*  */
+static size_t _tou_csv_index_select(const unsigned char* h, size_t* at, size_t end, unsigned char delim, unsigned char quote,
+	uint64_t* in_quotes, size_t* offs, size_t max)
+{
+	_tou_csv_index_kernel_t kernel = _tou_csv_index_pick();
+	_TOU_STORE_RELAXED(&_tou_g_csv_index_kernel, kernel);
+	return kernel(h, at, end, delim, quote, in_quotes, offs, max);
+}
+
+
+/* Picks all kernels up front; called before starting threads so they never race on the selectors */
+static void _tou_simd_init(void)
+{
+	_TOU_STORE_RELAXED(&_tou_g_sfind_kernel, _tou_sfind_pick());
+	_TOU_STORE_RELAXED(&_tou_g_index_kernel, _tou_index_byte_pick());
+	_TOU_STORE_RELAXED(&_tou_g_csv_index_kernel, _tou_csv_index_pick());
+}
+
+/* Like _tou_index_byte but for CSV separators outside of quotes */
+static size_t _tou_csv_index(const char* h, size_t hl, size_t* at, char delim, char quote, uint64_t* in_quotes, size_t* offs)
+{
+	size_t n = _TOU_LOAD_RELAXED(&_tou_g_csv_index_kernel)((const unsigned char*)h, at, hl, (unsigned char)delim, (unsigned char)quote, in_quotes, offs, _TOU_INDEX_BATCH);
+
+	if (*at + _TOU_INDEX_BLOCK > hl && n + _TOU_INDEX_BLOCK <= _TOU_INDEX_BATCH) {
+		// Less than a block left, it fits in the rest of the batch
+		uint64_t seps, quotes;
+		_tou_csv_masks_scalar((const unsigned char*)h + *at, hl - *at, (unsigned char)delim, (unsigned char)quote, &seps, &quotes);
+		_tou_csv_flatten(seps, quotes, in_quotes, *at, offs, &n);
+		*at = hl;
+	}
+	return n;
+}
+
+
+/*  */
+char* tou_sfind_n(const char* src, const char* kwd, size_t maxlen)
+{
+	if (src == NULL || kwd == NULL)
+		return NULL;
+
+	return _tou_find(src, maxlen, kwd, strlen(kwd), NULL);
+}
+
+
+/*
+	Case-insensitive search. The keyword is folded to lower case once, the
+	haystack only on the fly. SIMD kernels OR 0x20 into lanes compared against
+	letters, which maps exactly 'A'/'a' (etc.) onto the lower case letter and
+	nothing else, and compare other bytes as they are.
+*/
+#define _TOU_FOLD(c) ((unsigned char)((unsigned)((c) - 'A') < 26u ? ((c) | 0x20) : (c)))
+
+/* `nf` is already folded */
+static int _tou_ci_equal(const unsigned char* h, const unsigned char* nf, size_t l)
+{
+	for (size_t i = 0; i < l; i++) {
+		if (_TOU_FOLD(h[i]) != nf[i])
+			return 0;
+	}
+	return 1;
+}
+
+
+/* Two-Way over a folded keyword `nf`, folding the haystack while comparing */
+static const char* _tou_twoway_search_ci(const unsigned char* h, size_t hl, const unsigned char* nf, size_t l, const _tou_twoway_t* tw)
+{
+	const unsigned char* end = h + hl;
+	const size_t ms = tw->ms;
+	size_t mem = 0;
+	size_t k;
+
+	while ((size_t)(end - h) >= l) {
+		for (k = (ms + 1 > mem) ? ms + 1 : mem; k < l && nf[k] == _TOU_FOLD(h[k]); k++) ;
+		if (k < l) {
+			h += k - ms;
+			mem = 0;
+			continue;
+		}
+		for (k = ms + 1; k > mem && nf[k - 1] == _TOU_FOLD(h[k - 1]); k--) ;
+		if (k <= mem)
+			return (const char*)h;
+		h += tw->p;
+		mem = tw->mem0;
+	}
+
+	return NULL;
+}
+
+
+/*  */
+static const char* _tou_sfind_ci_scalar(const unsigned char* h, size_t hl, const unsigned char* nf, size_t l)
+{
+	_tou_twoway_t tw;
+	_tou_twoway_prep(nf, l, &tw);
+	return _tou_twoway_search_ci(h, hl, nf, l, &tw);
+}
+
+#ifdef _TOU_SIMD_X86
+
+/*  */
+__attribute__((target("sse2")))
+static const char* _tou_sfind_ci_sse2(const unsigned char* h, size_t hl, const unsigned char* nf, size_t l)
+{
+	const __m128i first    = _mm_set1_epi8((char)nf[0]);
+	const __m128i last     = _mm_set1_epi8((char)nf[l - 1]);
+	const __m128i first_or = _mm_set1_epi8((nf[0] >= 'a' && nf[0] <= 'z') ? 0x20 : 0);
+	const __m128i last_or  = _mm_set1_epi8((nf[l - 1] >= 'a' && nf[l - 1] <= 'z') ? 0x20 : 0);
+	size_t i = 0, work = 0;
+
+	for (; i + 16 + l - 1 <= hl; i += 16) {
+		__m128i bf = _mm_or_si128(_mm_loadu_si128((const __m128i*)(h + i)), first_or);
+		__m128i bl = _mm_or_si128(_mm_loadu_si128((const __m128i*)(h + i + l - 1)), last_or);
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(
+			_mm_and_si128(_mm_cmpeq_epi8(first, bf), _mm_cmpeq_epi8(last, bl)));
+
+		while (mask) {
+			size_t pos = i + __builtin_ctz(mask);
+			if (_tou_ci_equal(h + pos + 1, nf + 1, l - 2))
+				return (const char*)(h + pos);
+			work += l;
+			mask &= mask - 1;
+		}
+		if (work > i + _TOU_SFIND_WORK_SLACK)
+			break;
+	}
+
+	return _tou_sfind_ci_scalar(h + i, hl - i, nf, l);
+}
+
+/*  */
+__attribute__((target("avx2")))
+static const char* _tou_sfind_ci_avx2(const unsigned char* h, size_t hl, const unsigned char* nf, size_t l)
+{
+	const __m256i first    = _mm256_set1_epi8((char)nf[0]);
+	const __m256i last     = _mm256_set1_epi8((char)nf[l - 1]);
+	const __m256i first_or = _mm256_set1_epi8((nf[0] >= 'a' && nf[0] <= 'z') ? 0x20 : 0);
+	const __m256i last_or  = _mm256_set1_epi8((nf[l - 1] >= 'a' && nf[l - 1] <= 'z') ? 0x20 : 0);
+	size_t i = 0, work = 0;
+
+	for (; i + 32 + l - 1 <= hl; i += 32) {
+		__m256i bf = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(h + i)), first_or);
+		__m256i bl = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(h + i + l - 1)), last_or);
+		unsigned int mask = (unsigned int)_mm256_movemask_epi8(
+			_mm256_and_si256(_mm256_cmpeq_epi8(first, bf), _mm256_cmpeq_epi8(last, bl)));
+
+		while (mask) {
+			size_t pos = i + __builtin_ctz(mask);
+			if (_tou_ci_equal(h + pos + 1, nf + 1, l - 2))
+				return (const char*)(h + pos);
+			work += l;
+			mask &= mask - 1;
+		}
+		if (work > i + _TOU_SFIND_WORK_SLACK)
+			break;
+	}
+
+	_mm256_zeroupper(); // the scalar fallback may run legacy SSE code
+	return _tou_sfind_ci_scalar(h + i, hl - i, nf, l);
+}
+
+#endif
+
+
+static char* _tou_find_ci(const char* src, size_t maxlen, const char* kwd, size_t l);
+
+
+/*  */
+char* tou_sfind_ci(const char* src, const char* kwd)
+{
+	if (src == NULL)
+		return NULL;
+	return tou_sfind_ci_n(src, kwd, strlen(src));
+}
+
+
+/*  */
+char* tou_sfind_ci_n(const char* src, const char* kwd, size_t maxlen)
+{
+	if (src == NULL || kwd == NULL)
+		return NULL;
+
+	return _tou_find_ci(src, maxlen, kwd, strlen(kwd));
+}
+
+
+/*  */
+static char* _tou_find_ci(const char* src, size_t maxlen, const char* kwd, size_t l)
+{
+	const unsigned char* h = (const unsigned char*)src;
+
+	if (l > maxlen)
+		return NULL;
+	if (l == 0)
+		return (char*)src;
+	if (l == 1) {
+		unsigned char c = _TOU_FOLD((unsigned char)*kwd);
+		for (size_t i = 0; i < maxlen; i++) {
+			if (_TOU_FOLD(h[i]) == c)
+				return (char*)(src + i);
+		}
+		return NULL;
+	}
+
+	// Fold the keyword, on the stack if it's short enough
+	unsigned char nf_buf[256];
+	unsigned char* nf = (l <= sizeof nf_buf) ? nf_buf : malloc(l);
+	if (nf == NULL) {
+		// No memory for a long keyword: still answer, folding both sides while comparing
+		TOU_PRINTD("[sfind_ci] cannot allocate %zu bytes, searching without folding first\n", l);
+		for (size_t i = 0; i + l <= maxlen; i++) {
+			size_t k = 0;
+			while (k < l && _TOU_FOLD(h[i + k]) == _TOU_FOLD((unsigned char)kwd[k]))
+				k++;
+			if (k == l)
+				return (char*)(src + i);
+		}
+		return NULL;
+	}
+	for (size_t i = 0; i < l; i++)
+		nf[i] = _TOU_FOLD((unsigned char)kwd[i]);
+
+	const char* found;
+#ifdef _TOU_SIMD_X86
+	int features = _tou_cpu_features();
+	if (features & _TOU_CPU_AVX2)
+		found = _tou_sfind_ci_avx2(h, maxlen, nf, l);
+	else if (features & _TOU_CPU_SSE2)
+		found = _tou_sfind_ci_sse2(h, maxlen, nf, l);
+	else
+#endif
+		found = _tou_sfind_ci_scalar(h, maxlen, nf, l);
+
+	if (nf != nf_buf)
+		free(nf);
+	return (char*)found;
+}
+
+
+/*  */
+tou_pattern* tou_pattern_new(const char* kwd)
+{
+	if (kwd == NULL)
+		return NULL;
+
+	tou_pattern* pat = malloc(sizeof *pat);
+	if (pat == NULL)
+		return NULL;
+	if ((pat->kwd = tou_strdup(kwd)) == NULL) {
+		free(pat);
+		return NULL;
+	}
+
+	const unsigned char* n = (const unsigned char*)pat->kwd;
+	size_t l = strlen(kwd);
+	pat->len = l;
+
+	_tou_twoway_t tw = {0, 1, 0};
+	if (l > 0)
+		_tou_twoway_prep(n, l, &tw);
+	pat->tw_ms = tw.ms;
+	pat->tw_p = tw.p;
+	pat->tw_mem0 = tw.mem0;
+
+	// Distance from the last occurence of each byte to the end of the keyword
+	for (int b = 0; b < 256; b++)
+		pat->shift[b] = l;
+	for (size_t i = 0; i < l; i++)
+		pat->shift[n[i]] = l - 1 - i;
+
+	return pat;
+}
+
+
+/*  */
+void tou_pattern_destroy(tou_pattern* pat)
+{
+	if (pat == NULL)
+		return;
+	free(pat->kwd);
+	free(pat);
+}
+
+
+/*  */
+char* tou_sfind_pat(const char* str, const tou_pattern* pat)
+{
+	if (str == NULL)
+		return NULL;
+	return tou_sfind_pat_n(str, pat, strlen(str));
+}
+
+
+/*  */
+char* tou_sfind_pat_n(const char* str, const tou_pattern* pat, size_t maxlen)
+{
+	if (str == NULL || pat == NULL)
+		return NULL;
+	return _tou_find(str, maxlen, pat->kwd, pat->len, pat);
+}
+
+
+/*  */
+char* tou_sfind_multiple(const char* str, const char** kwds, int n_kwds, int* found_idx)
+{
+	return tou_sfind_multiple_n(str, kwds, n_kwds, found_idx, ((size_t)-1) - 1);
+}
+
+
+/* Length of `str` but looking at no more than `maxlen` bytes */
+static size_t _tou_strnlen(const char* str, size_t maxlen)
+{
+	size_t len = 0;
+	while (len < maxlen && str[len] != '\0')
+		len++;
+	return len;
+}
+
+
+/*  */
+char* tou_sfind_multiple_n(const char* str, const char** kwds, int n_kwds, int* found_idx, size_t maxlen)
+{
+	if (found_idx)
+		*found_idx = -1;
+
+	if (str == NULL || kwds == NULL || n_kwds < 1 || maxlen < 1)
+		return NULL;
+
+	tou_kwset* set = tou_kwset_new(kwds, n_kwds);
+	if (set == NULL)
+		return NULL;
+
+	char* found = tou_kwset_find_n(set, str, _tou_strnlen(str, maxlen), found_idx);
+	tou_kwset_destroy(set);
+	return found;
+}
+
+
+static tou_kwset* _tou_kwset_new(const char** kwds, int n_kwds, int fold_case);
+
+
+/*
+	Walks a keyword set over `src` calling `cb` for every match; `user_kwds`,
+	if given, are passed to the callback instead of the set's own copies.
+*/
+static void _tou_kwset_iter(const tou_kwset* set, const char* src, size_t len, tou_func3 cb, void* userdata, const char** user_kwds);
+
+
+/*  */
+void tou_sfind_iter_multiple(const char* src, const char* kwds[], int n_kwds, tou_func3 cb, void* userdata)
+{
+	tou_sfind_iter_multiple_n(src, kwds, n_kwds, cb, userdata, ((size_t)-1) - 1);
+}
+
+
+/*  */
+void tou_sfind_iter_multiple_n(const char* src, const char* kwds[], int n_kwds, tou_func3 cb, void* userdata, size_t maxlen)
+{
+	if (src == NULL || kwds == NULL || n_kwds < 1 || cb == NULL)
+		return;
+
+	tou_kwset* set = tou_kwset_new(kwds, n_kwds);
+	if (set == NULL)
+		return;
+
+	_tou_kwset_iter(set, src, _tou_strnlen(src, maxlen), cb, userdata, kwds);
+	tou_kwset_destroy(set);
+}
+
+
+/*  */
+tou_kwset* tou_kwset_new(const char** kwds, int n_kwds)
+{
+	return _tou_kwset_new(kwds, n_kwds, 0);
+}
+
+
+/*  */
+tou_kwset* tou_kwset_new_ci(const char** kwds, int n_kwds)
+{
+	return _tou_kwset_new(kwds, n_kwds, 1);
+}
+
+
+/*  */
+static tou_kwset* _tou_kwset_new(const char** kwds, int n_kwds, int fold_case)
+{
+	if (kwds == NULL || n_kwds < 1)
+		return NULL;
+
+	tou_kwset* set = calloc(1, sizeof *set);
+	if (set == NULL)
+		return NULL;
+	set->fold_case = fold_case;
+
+	int* fail = NULL;
+	int* queue = NULL;
+	size_t total_len = 0;
+
+	set->n_kwds = n_kwds;
+	set->kwds = calloc(n_kwds, sizeof *set->kwds);
+	set->kwd_lens = calloc(n_kwds, sizeof *set->kwd_lens);
+	if (set->kwds == NULL || set->kwd_lens == NULL)
+		goto jmp_kwset_new_fail;
+
+	// Copy keywords and assign classes to bytes which appear in them;
+	// everything else stays in class 0
+	for (int i = 0; i < n_kwds; i++) {
+		if (kwds[i] == NULL)
+			continue;
+		if ((set->kwds[i] = tou_strdup(kwds[i])) == NULL)
+			goto jmp_kwset_new_fail;
+		set->kwd_lens[i] = strlen(kwds[i]);
+		total_len += set->kwd_lens[i];
+		if (set->kwd_lens[i] > set->max_len)
+			set->max_len = set->kwd_lens[i];
+		for (size_t j = 0; j < set->kwd_lens[i]; j++)
+			set->classes[fold_case ? _TOU_FOLD((unsigned char)kwds[i][j]) : (unsigned char)kwds[i][j]] = 1;
+	}
+
+	int n_classes = 1;
+	for (int b = 0; b < 256; b++) {
+		if (set->classes[b])
+			set->classes[b] = n_classes++;
+	}
+	set->n_classes = n_classes;
+
+	// Upper case letters go into the same class as lower case ones
+	if (fold_case) {
+		for (int b = 'A'; b <= 'Z'; b++)
+			set->classes[b] = set->classes[b | 0x20];
+	}
+
+	// Worst case every keyword byte gets its own state
+	size_t max_states = total_len + 1;
+	set->delta = calloc(max_states * n_classes, sizeof *set->delta);
+	set->depth = calloc(max_states, sizeof *set->depth);
+	set->term  = malloc(max_states * sizeof *set->term);
+	set->dict  = malloc(max_states * sizeof *set->dict);
+	fail  = malloc(max_states * sizeof *fail);
+	queue = malloc(max_states * sizeof *queue);
+	if (!set->delta || !set->depth || !set->term || !set->dict || !fail || !queue)
+		goto jmp_kwset_new_fail;
+
+	// Build trie; while building, 0 in `delta` means "no edge"
+	// (nothing ever points back to the root)
+	int n_states = 1;
+	set->term[0] = -1;
+	for (int i = 0; i < n_kwds; i++) {
+		if (set->kwd_lens[i] == 0)
+			continue;
+		int state = 0;
+		for (size_t j = 0; j < set->kwd_lens[i]; j++) {
+			int* edge = &set->delta[state * n_classes + set->classes[(unsigned char)kwds[i][j]]];
+			if (*edge == 0) {
+				*edge = n_states;
+				set->depth[n_states] = set->depth[state] + 1;
+				set->term[n_states] = -1;
+				n_states++;
+			}
+			state = *edge;
+		}
+		if (set->term[state] < 0) // duplicates resolve to the first one
+			set->term[state] = i;
+	}
+	set->n_states = n_states;
+
+	// BFS to compute failure links and fill in the missing transitions
+	// so that the table becomes a complete DFA
+	int q_head = 0, q_tail = 0;
+	fail[0] = 0;
+	set->dict[0] = -1;
+	queue[q_tail++] = 0;
+
+	while (q_head < q_tail) {
+		int state = queue[q_head++];
+		int* row = &set->delta[state * n_classes];
+		int* fail_row = &set->delta[fail[state] * n_classes];
+
+		for (int c = 0; c < n_classes; c++) {
+			int next = row[c];
+			if (next != 0) {
+				// Trie edge
+				int f = (state == 0) ? 0 : fail_row[c];
+				fail[next] = f;
+				set->dict[next] = (set->term[f] >= 0) ? f : set->dict[f];
+				queue[q_tail++] = next;
+			} else {
+				row[c] = (state == 0) ? 0 : fail_row[c];
+			}
+		}
+	}
+
+	free(fail);
+	free(queue);
+
+	// Shrink to the used size
+	int* shrunk = realloc(set->delta, (size_t)n_states * n_classes * sizeof *set->delta);
+	if (shrunk)
+		set->delta = shrunk;
+
+	TOU_PRINTD("[kwset_new] %d keywords -> %d states x %d classes\n", n_kwds, n_states, n_classes);
+	return set;
+
+jmp_kwset_new_fail:
+	TOU_PRINTD("[kwset_new] allocation failed\n");
+	free(fail);
+	free(queue);
+	tou_kwset_destroy(set);
+	return NULL;
+}
+
+
+/*  */
+void tou_kwset_destroy(tou_kwset* set)
+{
+	if (set == NULL)
+		return;
+
+	if (set->kwds) {
+		for (int i = 0; i < set->n_kwds; i++)
+			free(set->kwds[i]);
+		free(set->kwds);
+	}
+	free(set->kwd_lens);
+	free(set->delta);
+	free(set->depth);
+	free(set->term);
+	free(set->dict);
+	free(set);
+}
+
+
+/*
+	Runs the automaton from the root over `text` looking for the leftmost-longest
+	match. Once a candidate is seen, scanning continues only while the current
+	state could still belong to a keyword starting at or before the candidate.
+
+	Returns 1 and fills in the match if one is certain (or `last` is set and one
+	is pending), otherwise 0. `keep` receives the offset from which the text must
+	be retained if more of it may follow (bytes that could start a match).
+*/
+static int _tou_kwset_scan(const tou_kwset* set, const unsigned char* text, size_t len, int last,
+	size_t* m_off, size_t* m_len, int* m_idx, size_t* keep)
+{
+	const int* delta = set->delta;
+	const int n_classes = set->n_classes;
+	int state = 0;
+	int best = -1;
+	size_t best_start = 0;
+
+	for (size_t i = 0; i < len; i++) {
+		state = delta[state * n_classes + set->classes[text[i]]];
+
+		if (best >= 0 && i + 1 - set->depth[state] > best_start)
+			goto jmp_kwset_scan_found;
+
+		int out = (set->term[state] >= 0) ? state : set->dict[state];
+		if (out >= 0) {
+			size_t out_start = i + 1 - set->depth[out];
+			if (best < 0 || out_start < best_start || (out_start == best_start && set->depth[out] > set->depth[best])) {
+				best = out;
+				best_start = out_start;
+			}
+		}
+	}
+
+	if (keep)
+		*keep = len - set->depth[state];
+	if (best < 0 || !last)
+		return 0;
+
+jmp_kwset_scan_found:
+	*m_off = best_start;
+	*m_len = set->depth[best];
+	*m_idx = set->term[best];
+	return 1;
+}
+
+
+/*
+	Walks all non-overlapping leftmost-longest matches of a keyword set with a
+	single pass of the automaton. Restarting _tou_kwset_scan after every match
+	would read up to `max_len` bytes of lookahead again each time.
+
+	For every start position still in play, the ring keeps the longest match
+	seen so far. A start is final once the automaton's state can no longer
+	belong to a keyword starting there, and only the last `max_len` starts
+	are ever pending. Final starts are then taken in order: the first one
+	with a match at or after the end of the previous match wins.
+*/
+#define _TOU_KWMATCH_STACK 64
+
+typedef struct {
+	const tou_kwset* set;
+	const unsigned char* text;
+	size_t len;
+	int last;         // text ends here, pending matches at the end are final
+	size_t i;         // bytes fed to the automaton
+	int state;
+	size_t cursor;    // next match has to start here or later
+	size_t decided;   // starts below this were taken or skipped
+	size_t frontier;  // starts below this are final
+	size_t pending;   // non-empty ring slots
+	size_t mask;      // ring size - 1
+	size_t* ring_len; // longest match per start (0 = none)
+	int* ring_idx;
+	size_t stack_len[_TOU_KWMATCH_STACK];
+	int stack_idx[_TOU_KWMATCH_STACK];
+} _tou_kwmatch_t;
+
+
+/*  */
+static void _tou_kwmatch_init(_tou_kwmatch_t* m, const tou_kwset* set, const char* text, size_t len, int last)
+{
+	m->set = set;
+	m->text = (const unsigned char*)text;
+	m->len = len;
+	m->last = last;
+	m->i = 0;
+	m->state = 0;
+	m->cursor = 0;
+	m->decided = 0;
+	m->frontier = 0;
+	m->pending = 0;
+
+	size_t size = 1;
+	while (size < set->max_len + 1)
+		size *= 2;
+	m->mask = size - 1;
+
+	if (size <= _TOU_KWMATCH_STACK) {
+		m->ring_len = m->stack_len;
+		m->ring_idx = m->stack_idx;
+	} else {
+		m->ring_len = malloc(size * sizeof *m->ring_len);
+		m->ring_idx = malloc(size * sizeof *m->ring_idx);
+		if (!m->ring_len || !m->ring_idx) {
+			TOU_PRINTD("[kwset] cannot allocate match window (%zu)\n", size);
+			free(m->ring_len);
+			free(m->ring_idx);
+			m->ring_len = NULL;
+			m->ring_idx = NULL;
+			m->set = NULL; // finds nothing
+			return;
+		}
+	}
+	memset(m->ring_len, 0, size * sizeof *m->ring_len);
+}
+
+
+/*  */
+static void _tou_kwmatch_destroy(_tou_kwmatch_t* m)
+{
+	if (m->ring_len != m->stack_len) {
+		free(m->ring_len);
+		free(m->ring_idx);
+	}
+}
+
+
+/* Offset from which the text has to be kept when more of it will follow */
+static size_t _tou_kwmatch_keep(const _tou_kwmatch_t* m)
+{
+	return (m->cursor > m->decided) ? m->cursor : m->decided;
+}
+
+
+/* Next match; returns 0 when there are no more (or, without `last`, none is certain yet) */
+static int _tou_kwmatch_next(_tou_kwmatch_t* m, size_t* m_off, size_t* m_len, int* m_idx)
+{
+	const tou_kwset* set = m->set;
+	if (set == NULL)
+		return 0;
+
+	const int* delta = set->delta;
+	const int n_classes = set->n_classes;
+	const size_t* depth = set->depth;
+	const int* term = set->term;
+	const int* dict = set->dict;
+
+	while (1) {
+		// Take final starts in order
+		if (m->pending == 0) {
+			m->decided = m->frontier;
+		} else {
+			while (m->decided < m->frontier) {
+				size_t slot = m->decided & m->mask;
+				size_t start = m->decided++;
+				size_t l = m->ring_len[slot];
+				if (l == 0)
+					continue;
+				m->ring_len[slot] = 0;
+				m->pending--;
+				if (start >= m->cursor) {
+					m->cursor = start + l;
+					*m_off = start;
+					*m_len = l;
+					*m_idx = m->ring_idx[slot];
+					return 1;
+				}
+			}
+		}
+
+		if (m->i == m->len) {
+			if (!m->last || m->frontier == m->len)
+				return 0;
+			m->frontier = m->len;
+			continue;
+		}
+
+		// Feed a byte; with nothing pending, keep going until some keyword ends
+		size_t i = m->i;
+		int state = m->state;
+		int out;
+		do {
+			state = delta[state * n_classes + set->classes[m->text[i++]]];
+			out = (term[state] >= 0) ? state : dict[state];
+		} while (out < 0 && m->pending == 0 && i < m->len);
+		m->i = i;
+		m->state = state;
+		m->frontier = i - depth[state];
+		if (m->pending == 0)
+			m->decided = m->frontier; // skipped starts had no matches
+
+		// Record every keyword ending here (longest first) for its start
+		for (; out >= 0; out = dict[out]) {
+			size_t start = i - depth[out];
+			if (start < m->cursor)
+				continue;
+			size_t slot = start & m->mask;
+			if (m->ring_len[slot] == 0)
+				m->pending++;
+			if (depth[out] > m->ring_len[slot]) {
+				m->ring_len[slot] = depth[out];
+				m->ring_idx[slot] = term[out];
+			}
+		}
+	}
+}
+
+
+/*  */
+char* tou_kwset_find(const tou_kwset* set, const char* str, int* found_idx)
+{
+	if (str == NULL) {
+		if (found_idx) *found_idx = -1;
+		return NULL;
+	}
+	return tou_kwset_find_n(set, str, strlen(str), found_idx);
+}
+
+
+/*  */
+char* tou_kwset_find_n(const tou_kwset* set, const char* str, size_t maxlen, int* found_idx)
+{
+	size_t m_off, m_len;
+	int m_idx = -1;
+
+	if (found_idx)
+		*found_idx = -1;
+	if (set == NULL || str == NULL)
+		return NULL;
+
+	if (!_tou_kwset_scan(set, (const unsigned char*)str, maxlen, 1, &m_off, &m_len, &m_idx, NULL))
+		return NULL;
+
+	if (found_idx)
+		*found_idx = m_idx;
+	return (char*)(str + m_off);
+}
+
+
+/*  */
+static void _tou_kwset_iter(const tou_kwset* set, const char* src, size_t len, tou_func3 cb, void* userdata, const char** user_kwds)
+{
+	size_t m_off, m_len;
+	int m_idx;
+	_tou_kwmatch_t m;
+	_tou_kwmatch_init(&m, set, src, len, 1);
+
+	while (_tou_kwmatch_next(&m, &m_off, &m_len, &m_idx)) {
+		const char* kwd = user_kwds ? user_kwds[m_idx] : set->kwds[m_idx];
+
+		// Call user func
+		if ((ssize_t)cb((void*)(src + m_off), (void*)kwd, userdata) == (ssize_t)TOU_BREAK) {
+			TOU_PRINTD("[kwset_iter] breaking early\n");
+			break;
+		}
+	}
+
+	_tou_kwmatch_destroy(&m);
+}
+
+
+/*  */
+void tou_kwset_iter(const tou_kwset* set, const char* src, tou_func3 cb, void* userdata)
+{
+	if (src == NULL)
+		return;
+	tou_kwset_iter_n(set, src, cb, userdata, strlen(src));
+}
+
+
+/*  */
+void tou_kwset_iter_n(const tou_kwset* set, const char* src, tou_func3 cb, void* userdata, size_t maxlen)
+{
+	if (set == NULL || src == NULL || cb == NULL)
+		return;
+	_tou_kwset_iter(set, src, maxlen, cb, userdata, NULL);
+}
+
+
+/*  */
+void tou_kwset_stream_init(tou_kwset_stream* st, const tou_kwset* set, tou_func3 cb, void* userdata)
+{
+	memset(st, 0, sizeof *st);
+	st->set = set;
+	st->cb = cb;
+	st->userdata = userdata;
+}
+
+
+/*
+	Reports final matches in `text` (which starts at stream offset `base`) that
+	start before `limit`. Returns the offset in `text` from which scanning has
+	to resume: the end of the last match, the start of a match at/after `limit`,
+	or the beginning of bytes that may still be part of a match.
+*/
+static size_t _tou_kwset_stream_run(tou_kwset_stream* st, const char* text, size_t len, size_t base, size_t limit, int last)
+{
+	size_t pos = 0, m_off, m_len;
+	int m_idx;
+	_tou_kwmatch_t m;
+	_tou_kwmatch_init(&m, st->set, text, len, last);
+
+	while (!st->stopped) {
+		if (!_tou_kwmatch_next(&m, &m_off, &m_len, &m_idx)) {
+			pos = last ? len : _tou_kwmatch_keep(&m);
+			break;
+		}
+		if (m_off >= limit) {
+			pos = m_off;
+			break;
+		}
+
+		tou_match match = {base + m_off, m_len, m_idx};
+		if (st->cb && (ssize_t)st->cb(&match, st->set->kwds[m_idx], st->userdata) == (ssize_t)TOU_BREAK) {
+			TOU_PRINTD("[kwset_stream] breaking early\n");
+			st->stopped = 1;
+		}
+		pos = m_off + m_len;
+	}
+
+	_tou_kwmatch_destroy(&m);
+	return pos;
+}
+
+
+/* Stores `data` at the end of the carry buffer */
+static int _tou_kwset_stream_carry(tou_kwset_stream* st, const char* data, size_t len)
+{
+	if (len == 0)
+		return 1;
+	if (st->carry_len + len > st->carry_cap) {
+		size_t new_cap = st->carry_cap ? st->carry_cap : 64;
+		while (new_cap < st->carry_len + len)
+			new_cap *= 2;
+		char* new_carry = realloc(st->carry, new_cap);
+		if (new_carry == NULL) {
+			TOU_PRINTD("[kwset_stream] cannot realloc carry (%zu bytes)\n", new_cap);
+			return 0;
+		}
+		st->carry = new_carry;
+		st->carry_cap = new_cap;
+	}
+	memcpy(st->carry + st->carry_len, data, len);
+	st->carry_len += len;
+	return 1;
+}
+
+
+/*  */
+int tou_kwset_stream_feed(tou_kwset_stream* st, const char* data, size_t len)
+{
+	if (st == NULL || st->set == NULL || st->stopped)
+		return TOU_BREAK;
+	if (data == NULL || len == 0)
+		return TOU_CONTINUE;
+
+	size_t chunk_start = 0;
+	size_t chunk_base = st->offset + st->carry_len;
+
+	if (st->carry_len > 0) {
+		// Matches starting in the carried bytes end at most `max_len` bytes
+		// into this chunk, so resolve them on a small joined window
+		size_t prev_len = st->carry_len;
+		size_t take = (len < st->set->max_len) ? len : st->set->max_len;
+		if (!_tou_kwset_stream_carry(st, data, take)) {
+			st->stopped = 1;
+			return TOU_BREAK;
+		}
+
+		if (take == len) {
+			// Whole chunk fits into the window, keep going from there
+			size_t keep = _tou_kwset_stream_run(st, st->carry, st->carry_len, st->offset, (size_t)-1, 0);
+			memmove(st->carry, st->carry + keep, st->carry_len - keep);
+			st->carry_len -= keep;
+			st->offset += keep;
+			return st->stopped ? TOU_BREAK : TOU_CONTINUE;
+		}
+
+		size_t resume = _tou_kwset_stream_run(st, st->carry, st->carry_len, st->offset, prev_len, 0);
+		chunk_start = ((resume > prev_len) ? resume : prev_len) - prev_len;
+		chunk_base = st->offset + prev_len;
+		st->carry_len = 0;
+		if (st->stopped)
+			return TOU_BREAK;
+	}
+
+	size_t keep = chunk_start + _tou_kwset_stream_run(st, data + chunk_start, len - chunk_start, chunk_base + chunk_start, (size_t)-1, 0);
+	st->offset = chunk_base + keep;
+	if (!st->stopped && !_tou_kwset_stream_carry(st, data + keep, len - keep))
+		st->stopped = 1;
+
+	return st->stopped ? TOU_BREAK : TOU_CONTINUE;
+}
+
+
+/*  */
+void tou_kwset_stream_finish(tou_kwset_stream* st)
+{
+	if (st == NULL)
+		return;
+
+	if (st->set && !st->stopped && st->carry_len > 0)
+		_tou_kwset_stream_run(st, st->carry, st->carry_len, st->offset, (size_t)-1, 1);
+
+	free(st->carry);
+	st->carry = NULL;
+	st->offset += st->carry_len;
+	st->carry_len = 0;
+	st->carry_cap = 0;
+}
+
+
+/*  */
+void* tou_kwset_stream_cb(void* blockdata, void* len, void* userdata)
+{
+	return (void*)(ssize_t)tou_kwset_stream_feed((tou_kwset_stream*)userdata, (const char*)blockdata, (size_t)len);
+}
+
+
+/* Stores a match into `out` if there's (or can be made) room for it */
+static void _tou_match_list_push(tou_match_list* out, size_t offset, size_t len, int idx)
+{
+	if (out->count == out->cap) {
+		if (!out->growable)
+			return;
+		size_t new_cap = out->cap ? out->cap * 2 : 16;
+		tou_match* new_items = realloc(out->items, new_cap * sizeof *new_items);
+		if (new_items == NULL) {
+			TOU_PRINTD("[match_list] cannot realloc items (%zu)\n", new_cap);
+			out->growable = 0; // keep counting, stop storing
+			return;
+		}
+		out->items = new_items;
+		out->cap = new_cap;
+	}
+	out->items[out->count].offset = offset;
+	out->items[out->count].len = len;
+	out->items[out->count].idx = idx;
+	out->count++;
+}
+
+
+/*  */
+static size_t _tou_sfind_all(const char* str, size_t len, const char* kwd, size_t kwd_len, const tou_pattern* pat, tou_match_list* out)
+{
+	size_t total = 0;
+	const char* found;
+
+	if (out)
+		out->count = 0;
+	if (kwd_len == 0)
+		return 0;
+
+	_tou_finder_t finder;
+	_tou_finder_init(&finder, str, len, kwd, kwd_len, pat);
+	while ((found = _tou_finder_next(&finder)) != NULL) {
+		if (out)
+			_tou_match_list_push(out, found - str, kwd_len, 0);
+		total++;
+	}
+
+	return total;
+}
+
+
+/*  */
+size_t tou_sfind_all(const char* str, const char* kwd, tou_match_list* out)
+{
+	if (str == NULL || kwd == NULL) {
+		if (out) out->count = 0;
+		return 0;
+	}
+	return _tou_sfind_all(str, strlen(str), kwd, strlen(kwd), NULL, out);
+}
+
+
+/*  */
+size_t tou_sfind_all_n(const char* str, const char* kwd, size_t maxlen, tou_match_list* out)
+{
+	if (str == NULL || kwd == NULL) {
+		if (out) out->count = 0;
+		return 0;
+	}
+	return _tou_sfind_all(str, maxlen, kwd, strlen(kwd), NULL, out);
+}
+
+
+/*  */
+size_t tou_sfind_all_multiple(const char* str, const tou_kwset* set, tou_match_list* out)
+{
+	return tou_sfind_all_multiple_n(str, set, tou_strlen(str), out);
+}
+
+
+/*  */
+size_t tou_sfind_all_multiple_n(const char* str, const tou_kwset* set, size_t maxlen, tou_match_list* out)
+{
+	size_t total = 0, m_off, m_len;
+	int m_idx;
+
+	if (out)
+		out->count = 0;
+	if (str == NULL || set == NULL)
+		return 0;
+
+	_tou_kwmatch_t m;
+	_tou_kwmatch_init(&m, set, str, maxlen, 1);
+	while (_tou_kwmatch_next(&m, &m_off, &m_len, &m_idx)) {
+		if (out)
+			_tou_match_list_push(out, m_off, m_len, m_idx);
+		total++;
+	}
+	_tou_kwmatch_destroy(&m);
+
+	return total;
+}
+
+
+/*
+	Parallel find-all: the buffer is cut into chunks which worker threads
+	pick up one by one. A chunk search reports matches *starting* in the
+	chunk, reading past its end only as far as a match can reach.
+
+	Workers start their non-overlapping chains at the chunk start, while the
+	sequential chain may enter the chunk elsewhere (if the last match of the
+	previous chunk spills over). While merging, the true next match is looked
+	up from where the previous one ended until it coincides with one from
+	the worker's list; from there on both chains are identical.
+*/
+typedef struct {
+	const char* str;
+	size_t len;
+	const char* kwd;
+	size_t kwd_len;
+	const tou_kwset* set;
+	size_t chunk_size;
+	size_t n_chunks;
+	size_t next_chunk;
+	tou_match_list* lists;
+#ifndef TOU_NO_THREADS
+	_tou_mutex_t lock;
+#endif
+} _tou_psearch_t;
+
+
+/* Appends matches starting in [from, to) to `out`; returns count and sets `*end` to the end of the last one */
+static size_t _tou_psearch_range(const _tou_psearch_t* ps, size_t from, size_t to, tou_match_list* out, size_t* end)
+{
+	size_t total = 0, pos = from;
+
+	if (ps->set) {
+		size_t win_end = (to + ps->set->max_len < ps->len) ? to + ps->set->max_len : ps->len;
+		size_t m_off, m_len;
+		int m_idx;
+		_tou_kwmatch_t m;
+		_tou_kwmatch_init(&m, ps->set, ps->str + pos, win_end - pos, win_end == ps->len);
+		while (_tou_kwmatch_next(&m, &m_off, &m_len, &m_idx)) {
+			if (pos + m_off >= to)
+				break;
+			if (out)
+				_tou_match_list_push(out, pos + m_off, m_len, m_idx);
+			total++;
+			if (end) *end = pos + m_off + m_len;
+		}
+		_tou_kwmatch_destroy(&m);
+	} else {
+		size_t win_end = (to + ps->kwd_len - 1 < ps->len) ? to + ps->kwd_len - 1 : ps->len;
+		const char* found;
+		while (pos < win_end && (found = _tou_find(ps->str + pos, win_end - pos, ps->kwd, ps->kwd_len, NULL)) != NULL) {
+			if (out)
+				_tou_match_list_push(out, found - ps->str, ps->kwd_len, 0);
+			total++;
+			pos = (found - ps->str) + ps->kwd_len;
+			if (end) *end = pos;
+		}
+	}
+
+	return total;
+}
+
+
+/*  */
+static void* _tou_psearch_worker(void* arg)
+{
+	_tou_psearch_t* ps = (_tou_psearch_t*)arg;
+
+	while (1) {
+		size_t k;
+#ifndef TOU_NO_THREADS
+		_tou_mutex_lock(&ps->lock);
+#endif
+		k = ps->next_chunk++;
+#ifndef TOU_NO_THREADS
+		_tou_mutex_unlock(&ps->lock);
+#endif
+		if (k >= ps->n_chunks)
+			break;
+
+		size_t from = k * ps->chunk_size;
+		size_t to = (from + ps->chunk_size < ps->len) ? from + ps->chunk_size : ps->len;
+		_tou_psearch_range(ps, from, to, &ps->lists[k], NULL);
+	}
+
+	return NULL;
+}
+
+
+/* Leftmost(-longest) match starting at or after `from`, which is known to start no later than `upto` */
+static void _tou_psearch_first(const _tou_psearch_t* ps, size_t from, const tou_match* upto, tou_match* m)
+{
+	if (ps->set) {
+		_tou_kwset_scan(ps->set, (const unsigned char*)ps->str + from, ps->len - from, 1, &m->offset, &m->len, &m->idx, NULL);
+		m->offset += from;
+	} else {
+		const char* found = _tou_find(ps->str + from, upto->offset + upto->len - from, ps->kwd, ps->kwd_len, NULL);
+		m->offset = found - ps->str;
+		m->len = ps->kwd_len;
+		m->idx = 0;
+	}
+}
+
+
+/*  */
+static size_t _tou_sfind_all_parallel(_tou_psearch_t* ps, tou_match_list* out, int nthreads)
+{
+	if (out)
+		out->count = 0;
+
+	if (nthreads <= 0)
+		nthreads = _tou_cpu_count();
+
+	// Chunks a few times smaller than len/nthreads balance the load better
+	size_t chunk_size = ps->len / ((size_t)nthreads * 4) + 1;
+	if (chunk_size < TOU_PARALLEL_MIN_CHUNK)
+		chunk_size = TOU_PARALLEL_MIN_CHUNK;
+
+#ifndef TOU_NO_THREADS
+	if (nthreads > 1 && ps->len > chunk_size) {
+		ps->chunk_size = chunk_size;
+		ps->n_chunks = (ps->len + chunk_size - 1) / chunk_size;
+		ps->next_chunk = 0;
+		ps->lists = calloc(ps->n_chunks, sizeof *ps->lists);
+	}
+
+	if (ps->lists == NULL)
+#endif
+		return _tou_psearch_range(ps, 0, ps->len, out, NULL);
+
+#ifndef TOU_NO_THREADS
+	for (size_t k = 0; k < ps->n_chunks; k++)
+		ps->lists[k].growable = 1;
+
+	if ((size_t)nthreads > ps->n_chunks)
+		nthreads = (int)ps->n_chunks;
+
+	_tou_simd_init(); // workers must not race on the lazy kernel selection
+	_tou_mutex_init(&ps->lock);
+	_tou_thread_t* threads = (nthreads > 1) ? malloc((size_t)(nthreads - 1) * sizeof *threads) : NULL;
+	int started = 0;
+	while (threads && started < nthreads - 1 && _tou_thread_create(&threads[started], _tou_psearch_worker, ps))
+		started++;
+	TOU_PRINTD("[sfind_all_parallel] %zu chunks of %zu bytes on %d threads\n", ps->n_chunks, ps->chunk_size, started + 1);
+
+	_tou_psearch_worker(ps); // calling thread helps out too
+	for (int i = 0; i < started; i++)
+		_tou_thread_join(threads[i]);
+	free(threads);
+	_tou_mutex_destroy(&ps->lock);
+
+	// Merge, stitching the chains together across chunk borders
+	size_t total = 0;
+	size_t end = 0;
+	for (size_t k = 0; k < ps->n_chunks; k++) {
+		tou_match_list* list = &ps->lists[k];
+		size_t chunk_start = k * ps->chunk_size;
+		size_t chunk_end = (k + 1 == ps->n_chunks) ? ps->len : (k + 1) * ps->chunk_size;
+		size_t j = 0;
+
+		// Matches starting before the chunk were all handled already
+		if (end < chunk_start)
+			end = chunk_start;
+
+		// An empty list proves nothing starts in the chunk; if the previous
+		// match didn't spill over, the chains agree from the chunk start
+		if (list->count == 0 || end == chunk_start) {
+			for (; j < list->count; j++) {
+				if (out)
+					_tou_match_list_push(out, list->items[j].offset, list->items[j].len, list->items[j].idx);
+				total++;
+			}
+			if (list->count > 0)
+				end = list->items[list->count - 1].offset + list->items[list->count - 1].len;
+			free(list->items);
+			continue;
+		}
+
+		// Desync: re-search from the end of the spilled match until the chains meet
+		while (1) {
+			while (j < list->count && list->items[j].offset < end)
+				j++;
+
+			if (j == list->count) {
+				// Nothing usable left from the worker; finish the chunk here
+				if (end < chunk_end)
+					total += _tou_psearch_range(ps, end, chunk_end, out, &end);
+				break;
+			}
+
+			tou_match m;
+			_tou_psearch_first(ps, end, &list->items[j], &m);
+			if (m.offset == list->items[j].offset && m.len == list->items[j].len) {
+				// In sync, take the rest as is
+				for (; j < list->count; j++) {
+					if (out)
+						_tou_match_list_push(out, list->items[j].offset, list->items[j].len, list->items[j].idx);
+					total++;
+				}
+				end = list->items[list->count - 1].offset + list->items[list->count - 1].len;
+				break;
+			}
+
+			if (out)
+				_tou_match_list_push(out, m.offset, m.len, m.idx);
+			total++;
+			end = m.offset + m.len;
+		}
+
+		free(list->items);
+	}
+	free(ps->lists);
+
+	return total;
+#endif
+}
+
+
+/*  */
+size_t tou_sfind_all_parallel(const char* str, const char* kwd, size_t maxlen, tou_match_list* out, int nthreads)
+{
+	if (str == NULL || kwd == NULL || *kwd == '\0') {
+		if (out) out->count = 0;
+		return 0;
+	}
+
+	_tou_psearch_t ps;
+	memset(&ps, 0, sizeof ps);
+	ps.str = str;
+	ps.len = maxlen;
+	ps.kwd = kwd;
+	ps.kwd_len = strlen(kwd);
+
+	return _tou_sfind_all_parallel(&ps, out, nthreads);
+}
+
+
+/*  */
+size_t tou_sfind_all_multiple_parallel(const char* str, const tou_kwset* set, size_t maxlen, tou_match_list* out, int nthreads)
+{
+	if (str == NULL || set == NULL) {
+		if (out) out->count = 0;
+		return 0;
+	}
+
+	_tou_psearch_t ps;
+	memset(&ps, 0, sizeof ps);
+	ps.str = str;
+	ps.len = maxlen;
+	ps.set = set;
+
+	return _tou_sfind_all_parallel(&ps, out, nthreads);
+}
+
+
+/*  */
+size_t tou_scount(const char* str, const char* kwd)
+{
+	return tou_sfind_all(str, kwd, NULL);
+}
+
+
+/*  */
+size_t tou_scount_n(const char* str, const char* kwd, size_t maxlen)
+{
+	return tou_sfind_all_n(str, kwd, maxlen, NULL);
+}
+
+
+/*  */
+static tou_llist_t* _tou_split(const char* str, size_t str_len, const char* delim, size_t delim_len, const tou_pattern* pat)
+{
+	TOU_PRINTD("[tou_split] STR_LEN :: %zu\n", str_len);
+
+	const char* str_end = str + str_len;
+	tou_llist_t* list = NULL;
+	const char* pos_start = str;
+	const char* pos_delim = NULL;
+
+	// Single byte delimiters are indexed in bulk
+	size_t offs[_TOU_INDEX_BATCH];
+	size_t n_offs = 0, i_offs = 0, at = 0;
+	if (delim_len == 1) {
+		while (n_offs == 0 && at < str_len)
+			n_offs = _tou_index_byte(str, str_len, &at, *delim, offs);
+		pos_delim = (n_offs > 0) ? str + offs[i_offs++] : NULL;
+	} else if (delim_len > 0) {
+		pos_delim = _tou_find(str, str_len, delim, delim_len, pat);
+	}
+
+	while (pos_delim) {
+		char* buf = malloc(pos_delim-pos_start + 1);
+		memcpy(buf, pos_start, pos_delim-pos_start);
+		buf[pos_delim-pos_start] = '\0';
+		TOU_PRINTD("[tou_split] BUF: %s\n", buf);
+		tou_llist_appendone(&list, buf, 1);
+
+		// Find next occurence
+		pos_start = pos_delim + delim_len;
+		if (delim_len == 1) {
+			if (i_offs == n_offs) {
+				n_offs = i_offs = 0;
+				while (n_offs == 0 && at < str_len)
+					n_offs = _tou_index_byte(str, str_len, &at, *delim, offs);
+			}
+			pos_delim = (i_offs < n_offs) ? str + offs[i_offs++] : NULL;
+		} else {
+			pos_delim = _tou_find(pos_start, str_end - pos_start, delim, delim_len, pat);
+		}
+	}
+
+	size_t len = str_end - pos_start;
+	TOU_PRINTD("[tou_split] FINAL LEN :: %zu\n", len);
+	if (len > 0) {
+		// Append last part till the end
+		char* buf = malloc(len + 1);
+		memcpy(buf, pos_start, len);
+		buf[len] = '\0';
+		TOU_PRINTD("[tou_split] BUF: %s\n", buf);
+		tou_llist_appendone(&list, buf, 1);
+	}
+
+	return list;//tou_llist_get_tail(list);
+}
+
+
+/*  */
+tou_llist_t* tou_split(char* str, const char* delim)
+{
+	if (!str || !delim)
+		return NULL;
+
+	return _tou_split(str, strlen(str), delim, strlen(delim), NULL);
+}
+
+
+/*  */
+tou_llist_t* tou_split_pat(char* str, const tou_pattern* delim)
+{
+	if (!str || !delim)
+		return NULL;
+
+	return _tou_split(str, strlen(str), delim->kwd, delim->len, delim);
+}
+
+
+/*  */
+char* tou_sappend(char* dst, char* src)
+{
+	size_t dst_len = tou_strlen(dst);
+	size_t src_len = tou_strlen(src);
+
+	size_t new_size = dst_len + src_len + 1;
+	dst = realloc(dst, new_size);
+	tou_strlcpy(dst + dst_len, src, new_size);
+
+	return dst;
+}
+
+
+/*  */
+char* tou_sappendch(char* dst, char src)
+{
+	size_t dst_len = tou_strlen(dst);
+
+	size_t new_size = dst_len + 1 + 1;
+	dst = realloc(dst, new_size);
+
+	*(dst + dst_len) = src;
+	*(dst + dst_len + 1) = '\0';
+
+	return dst;
+}
+
+
+/*  */
+char* tou_sprepend(char* dst, char* src)
+{
+	size_t dst_len = tou_strlen(dst);
+	size_t src_len = tou_strlen(src);
+
+	char* new_mem = malloc(dst_len + src_len + 1);
+
+	memcpy(new_mem,           src, src_len);
+	memcpy(new_mem + src_len, dst, dst_len + 1); // copy \0 too
+
+	return new_mem;
+}
+
+
+/*  */
+char* tou_sprependch(char* dst, char src)
+{
+	size_t dst_len = tou_strlen(dst);
+
+	char* new_mem = malloc(dst_len + 1 + 1);
+
+	*new_mem = src;
+	memcpy(new_mem + 1, dst, dst_len + 1); // don't forget to copy \0 too
+
+	return new_mem;
+}
+
+
+static char* _tou_sreplace(char* str, const char* repl_str, size_t repl_len, const tou_pattern* pat, char* with_str, size_t* len_ptr);
+static char* _tou_sreplace_range(const char* str, size_t len, size_t true_len, const char* repl_str, size_t repl_len, const tou_pattern* pat, const char* with_str, size_t with_len, size_t* len_ptr);
+
+
+/*  */
+char* tou_sreplace(char* str, char* repl_str, char* with_str)
+{
+	return tou_sreplace_n(str, repl_str, with_str, NULL);
+}
+
+
+/*  */
+char* tou_sreplace_n(char* str, char* repl_str, char* with_str, size_t* len_ptr)
+{
+	if (!str || !repl_str) {
+		TOU_PRINTD("[tou_sreplace_n] string or replace string NULL\n");
+		return NULL;
+	}
+
+	return _tou_sreplace(str, repl_str, strlen(repl_str), NULL, with_str, len_ptr);
+}
+
+
+/*  */
+char* tou_sreplace_pat(char* str, const tou_pattern* repl, char* with_str, size_t* len_ptr)
+{
+	if (!str || !repl) {
+		TOU_PRINTD("[tou_sreplace_pat] string or replace pattern NULL\n");
+		return NULL;
+	}
+
+	return _tou_sreplace(str, repl->kwd, repl->len, repl, with_str, len_ptr);
+}
+
+
+/*  */
+static char* _tou_sreplace(char* str, const char* repl_str, size_t repl_len, const tou_pattern* pat, char* with_str, size_t* len_ptr)
+{
+	size_t true_len = tou_strlen(str);
+	
+	size_t len = 0;
+	if (len_ptr != NULL) {
+		len = *len_ptr;
+	}
+	if (len == 0 || len > true_len)
+		len = true_len;
+
+	return _tou_sreplace_range(str, len, true_len, repl_str, repl_len, pat, with_str, tou_strlen(with_str), len_ptr);
+}
+
+
+/*
+	Replaces within the first `len` bytes of `str` and copies the rest up to
+	`true_len` unmodified. Never writes to `str` and doesn't need it terminated.
+
+	The first pass only counts matches, then the result is allocated once at
+	its exact size and filled with bulk copies while finding them again.
+*/
+static char* _tou_sreplace_range(const char* str, size_t len, size_t true_len, const char* repl_str, size_t repl_len, const tou_pattern* pat, const char* with_str, size_t with_len, size_t* len_ptr)
+{
+	_tou_finder_t finder;
+	size_t count = 0;
+
+	_tou_finder_init(&finder, str, len, repl_str, repl_len, pat);
+	while (_tou_finder_next(&finder) != NULL)
+		count++;
+
+	// true_len - count*repl_len + count*with_len, without going below zero in between
+	size_t new_len = true_len - count * repl_len;
+	if (with_len > 0 && count > (SIZE_MAX - new_len - 1) / with_len) {
+		TOU_PRINTD("[tou_sreplace] result too large\n");
+		return NULL;
+	}
+	new_len += count * with_len;
+
+	char* dst = malloc(new_len + 1);
+	if (dst == NULL) {
+		TOU_PRINTD("[tou_sreplace] malloc failed (%zu bytes)\n", new_len + 1);
+		return NULL;
+	}
+
+	const char* src = str;
+	const char* found;
+	char* out = dst;
+
+	_tou_finder_init(&finder, str, len, repl_str, repl_len, pat);
+	while ((found = _tou_finder_next(&finder)) != NULL) {
+		size_t copydiff = found - src;
+
+		memcpy(out, src, copydiff);
+		out += copydiff;
+		if (with_len > 0)
+			memcpy(out, with_str, with_len);
+		out += with_len;
+		src = found + repl_len;
+	}
+
+	// Last part + non-searched remainder
+	memcpy(out, src, str + true_len - src);
+	dst[new_len] = '\0';
+
+	if (len_ptr) {
+		*len_ptr = new_len;
+	}
+	return dst;
+}
+
+
+/*  */
+char* tou_sreplace_inplace(char* str, const char* repl_str, const char* with_str, size_t* len_ptr)
+{
+	if (!str || !repl_str) {
+		TOU_PRINTD("[tou_sreplace_inplace] string or replace string NULL\n");
+		return NULL;
+	}
+
+	size_t repl_len = strlen(repl_str);
+	size_t with_len = tou_strlen(with_str);
+	if (with_len > repl_len) {
+		TOU_PRINTD("[tou_sreplace_inplace] replacement longer than replaced string\n");
+		return NULL;
+	}
+
+	size_t true_len = strlen(str);
+	size_t len = (len_ptr != NULL) ? *len_ptr : 0;
+	if (len == 0 || len > true_len)
+		len = true_len;
+
+	// Matches are found in the original bytes ahead of `out`, which never overtakes `src`
+	const char* src = str;
+	char* out = str;
+	const char* found;
+	_tou_finder_t finder;
+	_tou_finder_init(&finder, str, len, repl_str, repl_len, NULL);
+	while ((found = _tou_finder_next(&finder)) != NULL) {
+		size_t copydiff = found - src;
+
+		if (out != src)
+			memmove(out, src, copydiff);
+		out += copydiff;
+		if (with_len > 0)
+			memcpy(out, with_str, with_len);
+		out += with_len;
+		src = found + repl_len;
+	}
+
+	size_t rest = str + true_len - src;
+	if (out != src)
+		memmove(out, src, rest);
+	out[rest] = '\0';
+
+	if (len_ptr) {
+		*len_ptr = (out + rest) - str;
+	}
+	return str;
+}
+
+
+/*
+	Walks the leftmost-longest matches of `set` and produces the text with
+	every match replaced by `to[idx]`: into `dst` if given (it has to be large
+	enough), through `cb` if given, or neither just to measure the output.
+*/
+static size_t _tou_sreplace_multi(const tou_kwset* set, const char* str, size_t len, const char** to, const size_t* to_lens,
+	char* dst, tou_func3 cb, void* userdata)
+{
+	size_t copied = 0, out_len = 0;
+	size_t m_off, m_len;
+	int m_idx;
+	_tou_kwmatch_t m;
+	_tou_kwmatch_init(&m, set, str, len, 1);
+
+	while (1) {
+		int found = _tou_kwmatch_next(&m, &m_off, &m_len, &m_idx);
+		size_t span = found ? m_off - copied : len - copied;
+
+		// Unchanged text up to the match (or to the end)
+		if (span > 0) {
+			if (dst)
+				memcpy(dst + out_len, str + copied, span);
+			if (cb && (ssize_t)cb((void*)(str + copied), (void*)span, userdata) == (ssize_t)TOU_BREAK) {
+				out_len += span;
+				break;
+			}
+			out_len += span;
+		}
+		if (!found)
+			break;
+
+		size_t with_len = to_lens[m_idx];
+		if (with_len > 0) {
+			if (dst)
+				memcpy(dst + out_len, to[m_idx], with_len);
+			if (cb && (ssize_t)cb((void*)to[m_idx], (void*)with_len, userdata) == (ssize_t)TOU_BREAK) {
+				out_len += with_len;
+				break;
+			}
+			out_len += with_len;
+		}
+
+		copied = m_off + m_len;
+	}
+
+	_tou_kwmatch_destroy(&m);
+	return out_len;
+}
+
+
+/* Lengths of the replacements, on the stack for the usual handful */
+#define _TOU_SREPLACE_MULTI_STACK 32
+
+static size_t* _tou_sreplace_multi_lens(const char** to, int n, size_t* stack_buf)
+{
+	size_t* lens = (n <= _TOU_SREPLACE_MULTI_STACK) ? stack_buf : malloc((size_t)n * sizeof *lens);
+	if (lens == NULL)
+		return NULL;
+
+	for (int i = 0; i < n; i++)
+		lens[i] = tou_strlen(to[i]);
+	return lens;
+}
+
+
+/*  */
+char* tou_sreplace_multi(const char* str, const char** from, const char** to, int n)
+{
+	if (str == NULL || from == NULL || to == NULL || n < 1) {
+		TOU_PRINTD("[tou_sreplace_multi] invalid params\n");
+		return NULL;
+	}
+
+	tou_kwset* set = tou_kwset_new(from, n);
+	if (set == NULL)
+		return NULL;
+
+	char* result = tou_sreplace_multi_set(str, set, to, NULL);
+	tou_kwset_destroy(set);
+	return result;
+}
+
+
+/*  */
+char* tou_sreplace_multi_set(const char* str, const tou_kwset* set, const char** to, size_t* len_ptr)
+{
+	if (str == NULL || set == NULL || to == NULL) {
+		TOU_PRINTD("[tou_sreplace_multi_set] invalid params\n");
+		return NULL;
+	}
+
+	size_t true_len = strlen(str);
+	size_t len = (len_ptr != NULL) ? *len_ptr : 0;
+	if (len == 0 || len > true_len)
+		len = true_len;
+
+	size_t lens_buf[_TOU_SREPLACE_MULTI_STACK];
+	size_t* to_lens = _tou_sreplace_multi_lens(to, set->n_kwds, lens_buf);
+	if (to_lens == NULL)
+		return NULL;
+
+	// Measure first, then fill an exactly sized buffer
+	size_t new_len = _tou_sreplace_multi(set, str, len, to, to_lens, NULL, NULL, NULL) + (true_len - len);
+	char* dst = malloc(new_len + 1);
+	if (dst != NULL) {
+		size_t out_len = _tou_sreplace_multi(set, str, len, to, to_lens, dst, NULL, NULL);
+		memcpy(dst + out_len, str + len, true_len - len);
+		dst[new_len] = '\0';
+		if (len_ptr)
+			*len_ptr = new_len;
+	} else {
+		TOU_PRINTD("[tou_sreplace_multi_set] malloc failed (%zu bytes)\n", new_len + 1);
+	}
+
+	if (to_lens != lens_buf)
+		free(to_lens);
+	return dst;
+}
+
+
+/*  */
+size_t tou_sreplace_multi_cb(const char* str, size_t len, const tou_kwset* set, const char** to, tou_func3 cb, void* userdata)
+{
+	if (str == NULL || set == NULL || to == NULL || cb == NULL)
+		return 0;
+
+	size_t lens_buf[_TOU_SREPLACE_MULTI_STACK];
+	size_t* to_lens = _tou_sreplace_multi_lens(to, set->n_kwds, lens_buf);
+	if (to_lens == NULL)
+		return 0;
+
+	size_t out_len = _tou_sreplace_multi(set, str, len, to, to_lens, NULL, cb, userdata);
+
+	if (to_lens != lens_buf)
+		free(to_lens);
+	return out_len;
+}
+
+
+/* Writes a piece to the FILE* in `userdata` */
+static void* _tou_fwrite_cb(void* data, void* len, void* userdata)
+{
+	size_t size = (size_t)len;
+	FILE* fp = (FILE*)userdata;
+
+	if (fwrite(data, 1, size, fp) != size) {
+		TOU_PRINTD("[tou_fwrite_cb] write failed\n");
+		return (void*)TOU_BREAK;
+	}
+	return (void*)TOU_CONTINUE;
+}
+
+
+/*  */
+size_t tou_sreplace_multi_fp(const char* str, size_t len, const tou_kwset* set, const char** to, FILE* fp)
+{
+	if (fp == NULL)
+		return 0;
+
+	return tou_sreplace_multi_cb(str, len, set, to, _tou_fwrite_cb, fp);
+}
+
+
+#ifndef _TOU_SREPLACE_STREAM_BLOCKSIZE
+#define _TOU_SREPLACE_STREAM_BLOCKSIZE (64 * 1024)
+#endif
+#ifndef _TOU_SREPLACE_STREAM_OUTBUF
+#define _TOU_SREPLACE_STREAM_OUTBUF (256 * 1024)
+#endif
+
+typedef struct {
+	FILE* out;
+	const char* repl;
+	size_t repl_len;
+	const tou_pattern* pat;
+	const char* with;
+	size_t with_len;
+	char* carry;      // unmatched bytes at the end of the last block, < repl_len
+	size_t carry_len;
+	char* join;       // `carry` followed by the start of the next block
+	char* outbuf;
+	size_t out_len;
+	size_t count;
+	char failed;
+} _tou_sreplace_stream_t;
+
+
+/* Writes out everything buffered so far */
+static int _tou_sreplace_stream_flush(_tou_sreplace_stream_t* st)
+{
+	if (st->out_len > 0 && fwrite(st->outbuf, 1, st->out_len, st->out) != st->out_len) {
+		TOU_PRINTD("[tou_sreplace_stream] write failed\n");
+		st->failed = 1;
+	}
+	st->out_len = 0;
+	return !st->failed;
+}
+
+
+/* Buffers `len` bytes of output; large pieces bypass the buffer */
+static void _tou_sreplace_stream_put(_tou_sreplace_stream_t* st, const char* data, size_t len)
+{
+	if (st->failed || len == 0)
+		return;
+
+	if (st->out_len + len > _TOU_SREPLACE_STREAM_OUTBUF) {
+		if (!_tou_sreplace_stream_flush(st))
+			return;
+		if (len >= _TOU_SREPLACE_STREAM_OUTBUF) {
+			if (fwrite(data, 1, len, st->out) != len) {
+				TOU_PRINTD("[tou_sreplace_stream] write failed\n");
+				st->failed = 1;
+			}
+			return;
+		}
+	}
+	memcpy(st->outbuf + st->out_len, data, len);
+	st->out_len += len;
+}
+
+
+/*
+	Replaces the matches in `buf` from `pos` on and outputs the text between
+	them, except for the trailing bytes which may start a match that ends in
+	the next block: those become the new carry.
+*/
+static void _tou_sreplace_stream_run(_tou_sreplace_stream_t* st, const char* buf, size_t len, size_t pos)
+{
+	const char* found;
+	_tou_finder_t finder;
+	_tou_finder_init(&finder, buf + pos, len - pos, st->repl, st->repl_len, st->pat);
+	while ((found = _tou_finder_next(&finder)) != NULL) {
+		size_t at = found - buf;
+		_tou_sreplace_stream_put(st, buf + pos, at - pos);
+		_tou_sreplace_stream_put(st, st->with, st->with_len);
+		pos = at + st->repl_len;
+		st->count++;
+	}
+
+	size_t keep_from = (len - pos >= st->repl_len) ? len - (st->repl_len - 1) : pos;
+	_tou_sreplace_stream_put(st, buf + pos, keep_from - pos);
+	memmove(st->carry, buf + keep_from, len - keep_from);
+	st->carry_len = len - keep_from;
+}
+
+
+/* Block callback of tou_sreplace_stream */
+static void* _tou_sreplace_stream_cb(void* blockdata, void* len, void* userdata)
+{
+	const char* block = (const char*)blockdata;
+	size_t size = (size_t)len;
+	_tou_sreplace_stream_t* st = (_tou_sreplace_stream_t*)userdata;
+	size_t l = st->repl_len;
+
+	if (l == 0) {
+		_tou_sreplace_stream_put(st, block, size);
+	} else if (st->carry_len + size < l) {
+		// Not enough for a match yet
+		memcpy(st->carry + st->carry_len, block, size);
+		st->carry_len += size;
+	} else if (st->carry_len > 0 && size < l - 1) {
+		// Short block, all of it fits next to the carry
+		memcpy(st->join, st->carry, st->carry_len);
+		memcpy(st->join + st->carry_len, block, size);
+		_tou_sreplace_stream_run(st, st->join, st->carry_len + size, 0);
+	} else {
+		// Matches starting in the carry end within the first `l - 1` bytes of the block
+		size_t skip = 0;
+		if (st->carry_len > 0) {
+			size_t join_len = st->carry_len + l - 1;
+			size_t pos = 0;
+			const char* found;
+			_tou_finder_t finder;
+
+			memcpy(st->join, st->carry, st->carry_len);
+			memcpy(st->join + st->carry_len, block, l - 1);
+			_tou_finder_init(&finder, st->join, join_len, st->repl, l, st->pat);
+			while ((found = _tou_finder_next(&finder)) != NULL && (size_t)(found - st->join) < st->carry_len) {
+				size_t at = found - st->join;
+				_tou_sreplace_stream_put(st, st->join + pos, at - pos);
+				_tou_sreplace_stream_put(st, st->with, st->with_len);
+				pos = at + l;
+				st->count++;
+			}
+			if (pos < st->carry_len)
+				_tou_sreplace_stream_put(st, st->join + pos, st->carry_len - pos);
+			else
+				skip = pos - st->carry_len;
+		}
+		_tou_sreplace_stream_run(st, block, size, skip);
+	}
+
+	if (st->failed)
+		return (void*)TOU_BREAK;
+	return (void*)TOU_CONTINUE;
+}
+
+
+/*  */
+size_t tou_sreplace_stream(FILE* in, FILE* out, const char* repl_str, const char* with_str)
+{
+	if (in == NULL || out == NULL || repl_str == NULL) {
+		TOU_PRINTD("[tou_sreplace_stream] stream or replace string NULL\n");
+		return 0;
+	}
+
+	_tou_sreplace_stream_t st = {0};
+	st.out = out;
+	st.repl = repl_str;
+	st.repl_len = strlen(repl_str);
+	st.with = (with_str != NULL) ? with_str : "";
+	st.with_len = strlen(st.with);
+
+	// Carry and join buffers hold less than two patterns
+	size_t keep = (st.repl_len > 0) ? st.repl_len - 1 : 0;
+	st.carry = malloc(keep + 1);
+	st.join = malloc(2 * keep + 1);
+	st.outbuf = malloc(_TOU_SREPLACE_STREAM_OUTBUF);
+	if (st.carry == NULL || st.join == NULL || st.outbuf == NULL) {
+		TOU_PRINTD("[tou_sreplace_stream] cannot allocate memory\n");
+		free(st.carry);
+		free(st.join);
+		free(st.outbuf);
+		return 0;
+	}
+	tou_pattern* pat = (st.repl_len > 0) ? tou_pattern_new(repl_str) : NULL;
+	st.pat = pat;
+
+	tou_read_fp_in_blocks(in, _TOU_SREPLACE_STREAM_BLOCKSIZE, _tou_sreplace_stream_cb, &st);
+
+	_tou_sreplace_stream_put(&st, st.carry, st.carry_len);
+	_tou_sreplace_stream_flush(&st);
+
+	tou_pattern_destroy(pat);
+	free(st.carry);
+	free(st.join);
+	free(st.outbuf);
+	return st.count;
+}
+
+
+/*  */
+tou_sv tou_sv_from(const char* str)
+{
+	tou_sv sv = { str, tou_strlen(str) };
+	return sv;
+}
+
+
+/*  */
+tou_sv tou_sv_make(const char* p, size_t n)
+{
+	tou_sv sv = { p, n };
+	return sv;
+}
+
+
+/*  */
+char* tou_sv_dup(tou_sv sv)
+{
+	char* buf = malloc(sv.n + 1);
+	if (buf == NULL)
+		return NULL;
+
+	if (sv.n > 0)
+		memcpy(buf, sv.p, sv.n);
+	buf[sv.n] = '\0';
+	return buf;
+}
+
+
+/*  */
+int tou_sv_cmp(tou_sv a, tou_sv b)
+{
+	size_t n = (a.n < b.n) ? a.n : b.n;
+	int cmp = (n > 0) ? memcmp(a.p, b.p, n) : 0;
+	if (cmp != 0)
+		return cmp;
+	return (a.n > b.n) - (a.n < b.n);
+}
+
+
+/*  */
+int tou_sv_eq(tou_sv a, tou_sv b)
+{
+	return a.n == b.n && (a.n == 0 || memcmp(a.p, b.p, a.n) == 0);
+}
+
+
+/*  */
+int tou_sv_eq_ci(tou_sv a, tou_sv b)
+{
+	if (a.n != b.n)
+		return 0;
+
+	for (size_t i = 0; i < a.n; i++) {
+		if (_TOU_FOLD((unsigned char)a.p[i]) != _TOU_FOLD((unsigned char)b.p[i]))
+			return 0;
+	}
+	return 1;
+}
+
+
+/*  */
+int tou_sv_starts_with(tou_sv sv, tou_sv prefix)
+{
+	return sv.n >= prefix.n && (prefix.n == 0 || memcmp(sv.p, prefix.p, prefix.n) == 0);
+}
+
+
+/*  */
+const char* tou_sfind_sv(tou_sv str, tou_sv kwd)
+{
+	if (str.p == NULL || kwd.n > str.n)
+		return NULL;
+
+	return _tou_find(str.p, str.n, kwd.p, kwd.n, NULL);
+}
+
+
+/*  */
+const char* tou_sfind_ci_sv(tou_sv str, tou_sv kwd)
+{
+	if (str.p == NULL || kwd.n > str.n)
+		return NULL;
+
+	return _tou_find_ci(str.p, str.n, kwd.p, kwd.n);
+}
+
+
+/*  */
+tou_sv tou_trim_front_sv(tou_sv sv)
+{
+	while (sv.n > 0 && TOU_IS_BLANK(*sv.p)) {
+		sv.p++;
+		sv.n--;
+	}
+	return sv;
+}
+
+
+/*  */
+tou_sv tou_trim_back_sv(tou_sv sv)
+{
+	sv.n = _tou_rskip_blank(sv.p, sv.n);
+	return sv;
+}
+
+
+/*  */
+tou_sv tou_trim_sv(tou_sv sv)
+{
+	return tou_trim_back_sv(tou_trim_front_sv(sv));
+}
+
+
+/*  */
+tou_llist_t* tou_split_sv(tou_sv str, tou_sv delim)
+{
+	if (str.p == NULL)
+		return NULL;
+
+	return _tou_split(str.p, str.n, delim.p, delim.n, NULL);
+}
+
+
+/* Stores a view into `out` if there's (or can be made) room for it */
+static void _tou_sv_list_push(tou_sv_list* out, const char* p, size_t n)
+{
+	if (out->count == out->cap) {
+		if (!out->growable)
+			return;
+		size_t new_cap = out->cap ? out->cap * 2 : 16;
+		tou_sv* new_items = realloc(out->items, new_cap * sizeof *new_items);
+		if (new_items == NULL) {
+			TOU_PRINTD("[sv_list] cannot realloc items (%zu)\n", new_cap);
+			out->growable = 0; // keep counting, stop storing
+			return;
+		}
+		out->items = new_items;
+		out->cap = new_cap;
+	}
+	out->items[out->count].p = p;
+	out->items[out->count].n = n;
+	out->count++;
+}
+
+
+/*  */
+size_t tou_split_views(char* str, size_t len, const char* delim, tou_sv_list* out, int terminate)
+{
+	if (out)
+		out->count = 0;
+	if (!str || !delim)
+		return 0;
+	if (len == 0)
+		len = strlen(str);
+
+	size_t delim_len = strlen(delim);
+	size_t total = 0;
+	char* pos_start = str;
+
+	if (delim_len == 1) {
+		// Offsets of a single byte delimiter are indexed in bulk
+		size_t offs[_TOU_INDEX_BATCH];
+		size_t at = 0;
+		while (at < len) {
+			size_t n_offs = _tou_index_byte(str, len, &at, *delim, offs);
+			total += n_offs;
+			for (size_t i = 0; i < n_offs; i++) {
+				char* pos_delim = str + offs[i];
+				if (out)
+					_tou_sv_list_push(out, pos_start, pos_delim - pos_start);
+				if (terminate)
+					*pos_delim = '\0'; // already indexed
+				pos_start = pos_delim + 1;
+			}
+		}
+	} else if (delim_len > 0) {
+		const char* found;
+		_tou_finder_t finder;
+		_tou_finder_init(&finder, str, len, delim, delim_len, NULL);
+		while ((found = _tou_finder_next(&finder)) != NULL) {
+			char* pos_delim = str + (found - str);
+			if (out)
+				_tou_sv_list_push(out, pos_start, pos_delim - pos_start);
+			if (terminate)
+				*pos_delim = '\0'; // already behind the finder
+			total++;
+			pos_start = pos_delim + delim_len;
+		}
+	}
+
+	// Last part till the end, unless empty (as in tou_split)
+	if (pos_start < str + len) {
+		if (out)
+			_tou_sv_list_push(out, pos_start, str + len - pos_start);
+		total++;
+	}
+	if (terminate)
+		str[len] = '\0';
+
+	return total;
+}
+
+
+/*  */
+void tou_split_iter_init(tou_split_iter* it, const char* str, size_t len, const char* delim)
+{
+	it->str = str;
+	it->len = (str && len == 0) ? strlen(str) : len;
+	it->delim = delim;
+	it->delim_len = delim ? strlen(delim) : 0;
+	it->pos = 0;
+	if (str == NULL)
+		it->pos = 1; // nothing to split
+}
+
+
+/*  */
+int tou_split_iter_next(tou_split_iter* it, const char** tok, size_t* tok_len)
+{
+	if (it->pos >= it->len) {
+		it->pos = it->len + 1;
+		return 0; // done, or only an empty last part left
+	}
+
+	const char* pos_start = it->str + it->pos;
+	size_t rest = it->len - it->pos;
+	const char* pos_delim = (it->delim_len > 0) ? _tou_find(pos_start, rest, it->delim, it->delim_len, NULL) : NULL;
+
+	*tok = pos_start;
+	if (pos_delim) {
+		*tok_len = pos_delim - pos_start;
+		it->pos += *tok_len + it->delim_len;
+	} else {
+		*tok_len = rest;
+		it->pos = it->len + 1;
+	}
+	return 1;
+}
+
+
+/*  */
+char* tou_sreplace_sv(tou_sv str, tou_sv repl, tou_sv with, size_t* len_ptr)
+{
+	if (str.p == NULL) {
+		TOU_PRINTD("[tou_sreplace_sv] string NULL\n");
+		return NULL;
+	}
+
+	return _tou_sreplace_range(str.p, str.n, str.n, repl.p, repl.n, NULL, with.p, with.n, len_ptr);
+}
+
+
+/*  */
+void tou_sbuf_init(tou_sbuf* sb)
+{
+	sb->data = NULL;
+	sb->len = 0;
+	sb->cap = 0;
+}
+
+
+/*  */
+void tou_sbuf_destroy(tou_sbuf* sb)
+{
+	if (sb == NULL)
+		return;
+
+	free(sb->data);
+	tou_sbuf_init(sb);
+}
+
+
+/*  */
+int tou_sbuf_reserve(tou_sbuf* sb, size_t extra)
+{
+	if (sb == NULL)
+		return -1;
+
+	size_t needed = sb->len + extra + 1;
+	if (needed < extra) // overflow
+		return -1;
+	if (needed <= sb->cap)
+		return 0;
+
+	size_t new_cap = (sb->cap < 16) ? 16 : sb->cap;
+	while (new_cap < needed) {
+		if (new_cap > SIZE_MAX / 2) {
+			new_cap = needed;
+			break;
+		}
+		new_cap *= 2;
+	}
+
+	char* new_data = realloc(sb->data, new_cap);
+	if (new_data == NULL) {
+		TOU_PRINTD("[tou_sbuf_reserve] realloc failed (%zu bytes)\n", new_cap);
+		return -1;
+	}
+	if (sb->data == NULL)
+		new_data[0] = '\0';
+
+	sb->data = new_data;
+	sb->cap = new_cap;
+	return 0;
+}
+
+
+/*  */
+int tou_sbuf_appendn(tou_sbuf* sb, const char* str, size_t n)
+{
+	if (tou_sbuf_reserve(sb, n) != 0)
+		return -1;
+
+	if (n > 0)
+		memcpy(sb->data + sb->len, str, n);
+	sb->len += n;
+	sb->data[sb->len] = '\0';
+	return 0;
+}
+
+
+/*  */
+int tou_sbuf_append(tou_sbuf* sb, const char* str)
+{
+	return tou_sbuf_appendn(sb, str, tou_strlen(str));
+}
+
+
+/*  */
+int tou_sbuf_appendch(tou_sbuf* sb, char ch)
+{
+	if (sb == NULL)
+		return -1;
+
+	if (sb->len + 1 >= sb->cap && tou_sbuf_reserve(sb, 1) != 0)
+		return -1;
+
+	sb->data[sb->len++] = ch;
+	sb->data[sb->len] = '\0';
+	return 0;
+}
+
+
+/*  */
+int tou_sbuf_appendf(tou_sbuf* sb, const char* format, ...)
+{
+	if (sb == NULL || format == NULL)
+		return -1;
+
+	// Try to fit it into what's left, most of the time it does
+	if (sb->cap == 0 && tou_sbuf_reserve(sb, 64) != 0)
+		return -1;
+
+	va_list args;
+	va_start(args, format);
+	int written = vsnprintf(sb->data + sb->len, sb->cap - sb->len, format, args);
+	va_end(args);
+
+	if (written < 0) {
+		sb->data[sb->len] = '\0';
+		return -1;
 	}
-	return src_len;
+
+	if ((size_t)written >= sb->cap - sb->len) {
+		// Didn't fit, grow and print again
+		if (tou_sbuf_reserve(sb, (size_t)written) != 0) {
+			sb->data[sb->len] = '\0';
+			return -1;
+		}
+		va_start(args, format);
+		vsnprintf(sb->data + sb->len, sb->cap - sb->len, format, args);
+		va_end(args);
+	}
+
+	sb->len += (size_t)written;
+	return 0;
 }
 
 
 /*  */
-size_t tou_strlcat(char* dst, const char* src, size_t size)
+void tou_sbuf_clear(tou_sbuf* sb)
 {
-	size_t src_len, dst_len;
+	if (sb == NULL)
+		return;
 
-	src_len = strlen (src);
-	dst_len = strlen (dst);
-	if (size > 0 && dst_len < size) 
-	{
-		size_t copy_cnt = size - dst_len - 1;
-		if (src_len < copy_cnt)
-			copy_cnt = src_len;
-		memcpy (dst + dst_len, src, copy_cnt);
-		dst[dst_len + copy_cnt] = '\0';
-	}
-	return src_len + dst_len;
+	sb->len = 0;
+	if (sb->data)
+		sb->data[0] = '\0';
 }
 
 
 /*  */
-size_t tou_strlen(const char* str)
+char* tou_sbuf_detach(tou_sbuf* sb)
 {
-	if (!str) return 0;
-	return strlen(str);
+	if (sb == NULL)
+		return NULL;
+
+	if (sb->data == NULL)
+		return tou_strdup("");
+
+	char* str = realloc(sb->data, sb->len + 1);
+	if (str == NULL) // can't shrink, hand over as is
+		str = sb->data;
+
+	tou_sbuf_init(sb);
+	return str;
 }
 
 
 /*  */
-char* tou_strdup(const char* src)
+void tou_dbuf_init(tou_dbuf* db)
 {
-	size_t src_len = strlen(src);
-	char* copy;
-	if ((copy = malloc(src_len + 1)) == NULL)
-		return NULL;
-	// tou_strlcpy(copy, src, src_len + 1);
-	memcpy(copy, src, src_len + 1);
-	return copy;
+	db->mem = NULL;
+	db->start = 0;
+	db->len = 0;
+	db->cap = 0;
 }
 
 
 /*  */
-char* tou_strndup(const char* src, size_t size)
+void tou_dbuf_destroy(tou_dbuf* db)
 {
-	size_t src_len = strlen(src);
-	char* copy = NULL;
+	if (db == NULL)
+		return;
 
-	if (size > 0) {
-		size_t copy_len = size;
-		if (src_len < copy_len)
-			copy_len = src_len;
-		if ((copy = malloc(copy_len + 1)) == NULL)
-			return NULL;
-		// tou_strlcpy(copy, src, copy_len + 1);
-		memcpy(copy, src, copy_len + 1);
-	}
-	return copy;
+	free(db->mem);
+	tou_dbuf_init(db);
 }
 
 
 /*  */
-char* tou_strchr(const char* src, int ch)
+int tou_dbuf_reserve(tou_dbuf* db, size_t front, size_t back)
 {
-	while (*src) {
-		if (*src == (char)ch)
-			return (char*)src;
-		src++;
+	if (db == NULL)
+		return -1;
+
+	// Enough room on both sides already (back keeps a byte for the NUL)
+	if (db->mem && db->start >= front && db->cap - db->start - db->len > back)
+		return 0;
+
+	size_t needed = db->len + front + back + 1;
+	if (needed < db->len || needed - db->len - 1 < front) // overflow
+		return -1;
+
+	if (db->mem && needed <= db->cap / 2) {
+		// Plenty of room overall, only the wrong side has it; re-center
+		size_t new_start = front + (db->cap - needed) / 2;
+		memmove(db->mem + new_start, db->mem + db->start, db->len + 1);
+		db->start = new_start;
+		return 0;
 	}
 
-	if (ch == '\0') // '\0' can also be searched for
-		return (char*)src;
-	else
-		return NULL;
+	size_t new_cap = (db->cap < 16) ? 16 : db->cap;
+	while (new_cap < needed * 2) {
+		if (new_cap > SIZE_MAX / 2) {
+			new_cap = needed;
+			break;
+		}
+		new_cap *= 2;
+	}
+
+	char* new_mem = malloc(new_cap);
+	if (new_mem == NULL) {
+		TOU_PRINTD("[tou_dbuf_reserve] malloc failed (%zu bytes)\n", new_cap);
+		return -1;
+	}
+
+	// Split the free room evenly between both ends
+	size_t new_start = front + (new_cap - needed) / 2;
+	if (db->mem)
+		memcpy(new_mem + new_start, db->mem + db->start, db->len);
+	new_mem[new_start + db->len] = '\0';
+
+	free(db->mem);
+	db->mem = new_mem;
+	db->start = new_start;
+	db->cap = new_cap;
+	return 0;
 }
 
 
 /*  */
-char* tou_strrchr(const char* src, int ch)
+const char* tou_dbuf_str(const tou_dbuf* db)
 {
-	char* pos = NULL;
+	if (db == NULL || db->mem == NULL)
+		return "";
+	return db->mem + db->start;
+}
 
-	while (*src) {
-		if (*src == (char)ch)
-			pos = (char*)src;
-		src++;
-	}
 
-	if (ch == '\0') // '\0' can also be searched for
-		return (char*)src;
-	else
-		return pos;
+/*  */
+int tou_dbuf_appendn(tou_dbuf* db, const char* str, size_t n)
+{
+	if (tou_dbuf_reserve(db, 0, n) != 0)
+		return -1;
+
+	char* end = db->mem + db->start + db->len;
+	if (n > 0)
+		memcpy(end, str, n);
+	end[n] = '\0';
+	db->len += n;
+	return 0;
 }
 
 
 /*  */
-char* tou_trim_string(char** str)
+int tou_dbuf_append(tou_dbuf* db, const char* str)
 {
-	tou_trim_back(str);
-	return tou_trim_front(str);
+	return tou_dbuf_appendn(db, str, tou_strlen(str));
 }
 
 
 /*  */
-char* tou_trim_front(char** str)
+int tou_dbuf_appendch(tou_dbuf* db, char ch)
 {
-	if (str == NULL || *str == NULL)
-		return NULL;
-	
-	char* ptr = *str;
-	while (*ptr != '\0' && TOU_IS_BLANK(*ptr))
-		ptr++;
-	*str = ptr;
-	return ptr;
+	return tou_dbuf_appendn(db, &ch, 1);
 }
 
 
 /*  */
-char* tou_trim_back(char** str)
+int tou_dbuf_prependn(tou_dbuf* db, const char* str, size_t n)
 {
-	if (str == NULL || *str == NULL)
-		return NULL;
+	if (tou_dbuf_reserve(db, n, 0) != 0)
+		return -1;
 
-	char* ptr = (*str + strlen(*str) - 1);
-	while (ptr >= *str && TOU_IS_BLANK(*ptr)) {
-		*ptr = '\0';
-		ptr--;
-	}
-	ptr++;
-	return ptr;
+	db->start -= n;
+	db->len += n;
+	if (n > 0)
+		memcpy(db->mem + db->start, str, n);
+	return 0;
 }
 
 
 /*  */
-void tou_trim_string_pure(char* str, char** start, char** end)
+int tou_dbuf_prepend(tou_dbuf* db, const char* str)
 {
-	char* back = tou_trim_back_pure(str);
-	char* front = tou_trim_front_pure(str);
+	return tou_dbuf_prependn(db, str, tou_strlen(str));
+}
 
-	*end = back;
-	*start = front;
+
+/*  */
+int tou_dbuf_prependch(tou_dbuf* db, char ch)
+{
+	return tou_dbuf_prependn(db, &ch, 1);
 }
 
 
 /*  */
-char* tou_trim_front_pure(char* str)
+char* tou_dbuf_detach(tou_dbuf* db)
 {
-	if (str == NULL)
+	if (db == NULL)
 		return NULL;
 
-	while (*str != '\0' && TOU_IS_BLANK(*str))
-		str++;
+	if (db->mem == NULL)
+		return tou_strdup("");
+
+	// Slide the contents to the front so the pointer can be free()'d
+	if (db->start > 0)
+		memmove(db->mem, db->mem + db->start, db->len + 1);
+
+	char* str = realloc(db->mem, db->len + 1);
+	if (str == NULL)
+		str = db->mem;
+
+	tou_dbuf_init(db);
 	return str;
 }
 
 
 /*  */
-char* tou_trim_back_pure(char* str)
+int tou_csv_init(tou_csv* csv, char delim, tou_func3 cb, void* userdata)
 {
-	if (str == NULL)
-		return NULL;
-
-	char* ptr = (str + strlen(str) - 1);
-	while (ptr >= str && TOU_IS_BLANK(*ptr)) {
-		ptr--;
+	memset(csv, 0, sizeof *csv);
+	csv->delim = delim;
+	csv->quote = '"';
+	csv->cb = cb;
+	csv->userdata = userdata;
+	csv->last = 1;
+
+	csv->offs = malloc(_TOU_INDEX_BATCH * sizeof *csv->offs);
+	if (csv->offs == NULL) {
+		TOU_PRINTD("[tou_csv_init] cannot allocate memory\n");
+		return -1;
 	}
-	ptr++; // Inc to point at the first trimmed/NUL byte
-	return ptr;
+	return 0;
 }
 
 
 /*  */
-char* tou_slower(char* str)
+void tou_csv_destroy(tou_csv* csv)
 {
-	if (!str)
-		return NULL;
+	if (csv == NULL)
+		return;
 
-	char* ptr = str;
-	while (*ptr++ = tolower(*ptr)) ;
-	return str;
+	free(csv->offs);
+	free(csv->fields);
+	tou_sbuf_destroy(&csv->unescaped);
+	tou_sbuf_destroy(&csv->carry);
+	csv->offs = NULL;
+	csv->fields = NULL;
+	csv->n_fields = csv->cap_fields = 0;
 }
 
-/*  */
-char* tou_supper(char* str)
-{
-	if (!str)
-		return NULL;
 
-	char* ptr = str;
-	while (*ptr++ = toupper(*ptr)) ;
-	return str;
+/* Starts splitting `data` into rows; it has to begin at the start of a row */
+static void _tou_csv_begin(tou_csv* csv, const char* data, size_t len, int last)
+{
+	csv->data = data;
+	csv->len = len;
+	csv->pos = 0;
+	csv->at = 0;
+	csv->in_quotes = 0;
+	csv->n_offs = 0;
+	csv->i_offs = 0;
+	csv->last = (char)last;
 }
 
 
 /*  */
-char* tou_replace_ch(char* ss, char oldch, char newch)
+void tou_csv_set_buffer(tou_csv* csv, const char* data, size_t len)
 {
-	TOU_PRINTD("[replace_ch] replacing ('%c'->'%c') \"%s\" => ", oldch, newch, ss);
-	char* ptr = tou_strchr(ss, oldch);
-	while (ptr) {
-		*ptr = newch;
-		ptr = tou_strchr(ptr + 1, oldch);
+	_tou_csv_begin(csv, data, len, 1);
+}
+
+
+/*
+	Adds the field data[start, end). Quoted fields lose their quotes; those
+	with doubled quotes are undone into `unescaped` and get a NULL pointer
+	until the row is complete, as `unescaped` may still move.
+*/
+static int _tou_csv_push(tou_csv* csv, size_t start, size_t end)
+{
+	if (csv->n_fields == csv->cap_fields) {
+		size_t new_cap = csv->cap_fields ? csv->cap_fields * 2 : 16;
+		tou_sv* new_fields = realloc(csv->fields, new_cap * sizeof *new_fields);
+		if (new_fields == NULL) {
+			TOU_PRINTD("[tou_csv] cannot realloc fields (%zu)\n", new_cap);
+			return -1;
+		}
+		csv->fields = new_fields;
+		csv->cap_fields = new_cap;
 	}
-	TOU_PRINTD("\"%s\"\n", ss);
-	return ss;
+
+	const char* p = csv->data + start;
+	size_t n = end - start;
+	const char quote = csv->quote;
+
+	if (quote && n > 0 && p[0] == quote) {
+		p++;
+		n--;
+		if (n > 0 && p[n - 1] == quote)
+			n--;
+
+		if (memchr(p, quote, n) != NULL) {
+			if (tou_sbuf_reserve(&csv->unescaped, n) != 0)
+				return -1;
+			char* dst = csv->unescaped.data + csv->unescaped.len;
+			size_t k = 0;
+			for (size_t i = 0; i < n; i++) {
+				dst[k++] = p[i];
+				if (p[i] == quote && i + 1 < n && p[i + 1] == quote)
+					i++; // "" stands for one quote
+			}
+			csv->unescaped.len += k;
+			p = NULL;
+			n = k;
+		}
+	}
+
+	csv->fields[csv->n_fields].p = p;
+	csv->fields[csv->n_fields].n = n;
+	csv->n_fields++;
+	return 0;
 }
 
 
-/*  */
-char* tou_sfind(const char* src, const char* kwd)
+/* Points the unescaped fields of a complete row into `unescaped` */
+static int _tou_csv_row_done(tou_csv* csv)
 {
-	return tou_sfind_n(src, kwd, strlen(src));
+	size_t off = 0;
+	for (size_t i = 0; csv->unescaped.len > 0 && i < csv->n_fields; i++) {
+		if (csv->fields[i].p == NULL) {
+			csv->fields[i].p = csv->unescaped.data + off;
+			off += csv->fields[i].n;
+		}
+	}
+	csv->rows++;
+	return 1;
 }
 
 
-/*  */
-char* tou_sfind_n(const char* src, const char* kwd, size_t maxlen)
+/*
+	Splits off the next row. Returns 0 when there's none left or, unless
+	`last` is set, the rest doesn't end with a newline yet; `pos` then
+	still points to the start of the unfinished row.
+*/
+static int _tou_csv_row(tou_csv* csv)
 {
-	if (src == NULL)
-		return NULL;
+	const char* data = csv->data;
+	const char quote = csv->quote;
+	size_t start = csv->pos;
 
-	const char* ret_ptr = NULL;
-	const int kwd_len = strlen(kwd);
-	const char* kwd_ptr = kwd;
+	csv->n_fields = 0;
+	csv->unescaped.len = 0;
+	if (csv->pos >= csv->len || csv->stopped)
+		return 0;
 
-	if (kwd_len > maxlen)
-		return NULL;
-	
-	while (maxlen + 1 > 0 ){//&& *src) {
-		if (*kwd_ptr == '\0') {
-			// only time it should be is when kwd is found
-			ret_ptr = src - kwd_len;
-			break;
+	while (1) {
+		if (csv->i_offs == csv->n_offs) {
+			if (csv->at >= csv->len)
+				break;
+			csv->i_offs = 0;
+			csv->n_offs = _tou_csv_index(data, csv->len, &csv->at, csv->delim, quote, &csv->in_quotes, csv->offs);
+			continue;
 		}
 
-		if (*src == '\0')
-			break;
-
-		if (*kwd_ptr == *src) {
-			kwd_ptr++;
-		} else {
-			kwd_ptr = kwd;
+		// Unquoted fields that fit are stored right here, kept in locals as
+		// stores to `fields` could otherwise alias the reader's members
+		tou_sv* fields = csv->fields;
+		size_t n_fields = csv->n_fields;
+		const size_t cap = csv->cap_fields;
+		const size_t* offs = csv->offs;
+		const size_t n_offs = csv->n_offs;
+		size_t i = csv->i_offs;
+		size_t o = 0, end = 0;
+		int eol = 0;
+
+		for (; i < n_offs; i++) {
+			o = offs[i];
+			eol = (data[o] == '\n');
+			end = (eol && o > start && data[o - 1] == '\r') ? o - 1 : o;
+			if (n_fields == cap || (quote && start < end && data[start] == quote))
+				break;
+			fields[n_fields].p = data + start;
+			fields[n_fields].n = end - start;
+			n_fields++;
+			start = o + 1;
+			if (eol)
+				break;
 		}
+		csv->n_fields = n_fields;
 
-		src++;
-		maxlen--;
+		if (i == n_offs) {
+			csv->i_offs = i;
+			continue;
+		}
+		csv->i_offs = i + 1;
+		if (start <= o) {
+			// Didn't fit or is quoted
+			if (_tou_csv_push(csv, start, end) != 0)
+				goto jmp_csv_row_error;
+			start = o + 1;
+		}
+		if (eol) {
+			csv->pos = o + 1;
+			return _tou_csv_row_done(csv);
+		}
 	}
 
-	return (char*)ret_ptr;
+	if (!csv->last)
+		return 0;
+
+	// Last row without a newline
+	if (_tou_csv_push(csv, start, csv->len) != 0)
+		goto jmp_csv_row_error;
+	csv->pos = csv->len;
+	return _tou_csv_row_done(csv);
+
+jmp_csv_row_error:
+	csv->stopped = 1;
+	csv->n_fields = 0;
+	return 0;
 }
 
 
 /*  */
-char* tou_sfind_multiple(const char* str, const char** kwds, int n_kwds, int* found_idx)
+int tou_csv_next_row(tou_csv* csv)
 {
-	return tou_sfind_multiple_n(str, kwds, n_kwds, found_idx, ((size_t)-1) - 1);
+	return _tou_csv_row(csv);
 }
 
 
-/*  */
-char* tou_sfind_multiple_n(const char* str, const char** kwds, int n_kwds, int* found_idx, size_t maxlen)
+/* Hands the current row to the callback */
+static void _tou_csv_deliver(tou_csv* csv)
 {
-	if (str == NULL || kwds == NULL || n_kwds < 1)
-		return NULL;
-
-	if (maxlen < 1) {
-		if (found_idx) *found_idx = -1;
-		return NULL;
+	if (csv->cb && (ssize_t)csv->cb(csv->fields, (void*)csv->n_fields, csv->userdata) == (ssize_t)TOU_BREAK) {
+		TOU_PRINTD("[tou_csv] breaking early\n");
+		csv->stopped = 1;
 	}
+}
 
-	int kwd_len[n_kwds];
-	const char* kwd_ptr[n_kwds];
-	const char* ret_ptr = NULL;
-
-	// Kwds which are NULL will not stop function but will be
-	// ignored later in search loop and their kwd_len will be set to 0
-	for (int i = 0; i < n_kwds; i++) {
-		kwd_ptr[i] = kwds[i];
-		kwd_len[i] = tou_strlen(kwds[i]);
-	}
 
-	while (maxlen + 1 > 0 && *str) {
-		for (int i = 0; i < n_kwds; i++) {
+/*  */
+int tou_csv_feed(tou_csv* csv, const char* data, size_t len)
+{
+	size_t from = 0;
 
-			if (kwd_ptr[i] == NULL) // Skip NULL keywords
-				continue;
-			if (*(kwd_ptr[i]) == '\0') {
-				// only time it should be is when that kwd is found
-				ret_ptr = str - kwd_len[i];
-				if (found_idx)
-					*found_idx = i;
-				goto jmp_sfind_multiple_n_break; // break;
-			}
+	if (csv->stopped)
+		return TOU_BREAK;
 
-			if (*(kwd_ptr[i]) == *str) {
-				kwd_ptr[i]++; // this character matched next char in this kwd
-			} else {
-				kwd_ptr[i] = kwds[i]; // reset this kwd tracker
+	if (csv->carry.len > 0) {
+		// Look for the end of the carried row, in the quote state it stopped in
+		uint64_t in_quotes = csv->in_quotes;
+		size_t at = 0, nl = len;
+		while (at < len && nl == len) {
+			size_t n = _tou_csv_index(data, len, &at, csv->delim, csv->quote, &in_quotes, csv->offs);
+			for (size_t i = 0; i < n; i++) {
+				if (data[csv->offs[i]] == '\n') {
+					nl = csv->offs[i];
+					break;
+				}
 			}
+		}
 
+		if (nl == len) {
+			// Still not finished
+			if (tou_sbuf_appendn(&csv->carry, data, len) != 0)
+				goto jmp_csv_feed_error;
+			csv->in_quotes = in_quotes;
+			return TOU_CONTINUE;
 		}
 
-		str++;
-		maxlen--;
+		if (tou_sbuf_appendn(&csv->carry, data, nl + 1) != 0)
+			goto jmp_csv_feed_error;
+		_tou_csv_begin(csv, csv->carry.data, csv->carry.len, 1);
+		if (_tou_csv_row(csv))
+			_tou_csv_deliver(csv);
+		tou_sbuf_clear(&csv->carry);
+		from = nl + 1;
 	}
 
-jmp_sfind_multiple_n_break:
-	// Do the check one more time in case matching string is found
-	// at the end of `str` (*str will break before the check has a chance)
-	for (int i = 0; i < n_kwds; i++) {
-		if (*(kwd_ptr[i]) == '\0') {
-			ret_ptr = str - kwd_len[i];
-			if (found_idx)
-				*found_idx = i;
-			break;
-		}
+	// Rows are parsed in place, only the unfinished one is copied
+	_tou_csv_begin(csv, data + from, len - from, 0);
+	while (_tou_csv_row(csv))
+		_tou_csv_deliver(csv);
+
+	if (csv->stopped)
+		return TOU_BREAK;
+	if (csv->pos < csv->len) {
+		if (tou_sbuf_appendn(&csv->carry, csv->data + csv->pos, csv->len - csv->pos) != 0)
+			goto jmp_csv_feed_error;
+		// `in_quotes` is already the state at the end of the chunk
 	}
-	return (char*)ret_ptr;
+	csv->data = NULL;
+	csv->len = csv->pos = csv->at = 0;
+	return TOU_CONTINUE;
+
+jmp_csv_feed_error:
+	TOU_PRINTD("[tou_csv_feed] cannot allocate memory\n");
+	csv->stopped = 1;
+	return TOU_BREAK;
 }
 
 
 /*  */
-void tou_sfind_iter_multiple(const char* src, const char* kwds[], int n_kwds, tou_func3 cb, void* userdata)
+void tou_csv_finish(tou_csv* csv)
 {
-	tou_sfind_iter_multiple_n(src, kwds, n_kwds, cb, userdata, ((size_t)-1) - 1);
+	if (csv->carry.len > 0 && !csv->stopped) {
+		_tou_csv_begin(csv, csv->carry.data, csv->carry.len, 1);
+		if (_tou_csv_row(csv))
+			_tou_csv_deliver(csv);
+	}
+	tou_sbuf_clear(&csv->carry);
+	_tou_csv_begin(csv, NULL, 0, 1);
 }
 
 
 /*  */
-void tou_sfind_iter_multiple_n(const char* src, const char* kwds[], int n_kwds, tou_func3 cb, void* userdata, size_t maxlen)
+void* tou_csv_cb(void* blockdata, void* len, void* userdata)
 {
-	char* found = NULL;
-	int found_idx = -1;
-	const char* text_ptr = src;
-	size_t remaining = maxlen - 0;
+	return (void*)(ssize_t)tou_csv_feed((tou_csv*)userdata, (const char*)blockdata, (size_t)len);
+}
 
-	while ((found = tou_sfind_multiple_n(text_ptr, kwds, n_kwds, &found_idx, remaining)) != NULL) {
-		// TOU_PRINTD("[iter_find_multiple_n] calling user func with (\"%s\", \"%s\", %p)\n", text_ptr, kwds[found_idx], userdata);
 
-		// Call user func
-		if ((ssize_t)cb((void*)found, (void*)kwds[found_idx], userdata) == (ssize_t)TOU_BREAK) {
-			TOU_PRINTD("[iter_find_multiple_n] breaking early\n");
-			return;
-		}
-		// Iter continue
-		text_ptr = found + tou_strlen(kwds[found_idx]);
-		remaining -= (text_ptr - src);
-	}
-}
+////////////////////////////////////////
+///              Files               ///
+////////////////////////////////////////
 
 
-/*  */
-tou_llist_t* tou_split(char* str, const char* delim)
+/* Allocates `size` bytes aligned to TOU_BLOCK_ALIGN; `*mem` receives what to free() */
+static char* _tou_block_alloc(size_t size, void** mem)
 {
-	if (!str || !delim)
+	if (size > SIZE_MAX - TOU_BLOCK_ALIGN || (*mem = malloc(size + TOU_BLOCK_ALIGN - 1)) == NULL)
 		return NULL;
+	uintptr_t addr = (uintptr_t)*mem;
+	return (char*)((addr + TOU_BLOCK_ALIGN - 1) & ~(uintptr_t)(TOU_BLOCK_ALIGN - 1));
+}
 
-	TOU_PRINTD("[tou_split] STR_LEN :: %zu\n", tou_strlen(str));
 
-	size_t delim_len = tou_strlen(delim);
-	tou_llist_t* list = NULL;
-	char* pos_start = str;
-	char* pos_delim = tou_sfind(str, delim);
-	
-	while (pos_delim) {
-		// TODO: swap with tou_str[n]dup() ?
-		char* buf = malloc(pos_delim-pos_start + 1);
-		tou_strlcpy(buf, pos_start, pos_delim-pos_start + 1);
-		TOU_PRINTD("[tou_split] BUF: %s\n", buf);
-		tou_llist_appendone(&list, buf, 1);
+/*  */
+int tou_block_reader_init(tou_block_reader* reader, size_t blocksize, char* buffer)
+{
+	if (blocksize == 0 || blocksize == (size_t)-1)
+		blocksize = TOU_DEFAULT_BLOCKSIZE;
 
-		// Find next occurence
-		pos_start = pos_delim + delim_len;
-		pos_delim = tou_sfind(pos_start, delim);
+	reader->blocksize = blocksize;
+	reader->len = 0;
+	reader->offset = 0;
+	reader->fp = NULL;
+	reader->fd = -1;
+	reader->positional = 0;
+	reader->error = 0;
+	reader->mem = NULL;
+	reader->buffer = buffer;
+
+	if (!buffer && (reader->buffer = _tou_block_alloc(blocksize, &reader->mem)) == NULL) {
+		TOU_PRINTD("[block_reader_init] cannot allocate %zu bytes\n", blocksize);
+		return -1;
 	}
 
-	size_t len = tou_strlen(pos_start);
-	TOU_PRINTD("[tou_split] FINAL LEN :: %zu\n", len);
-	if (len > 0) {
-		// Append last part till the end
-		// TODO: swap with tou_strndup() ?
-		char* buf = malloc(len + 1);
-		tou_strlcpy(buf, pos_start, len + 1);
-		TOU_PRINTD("[tou_split] BUF: %s\n", buf);
-		tou_llist_appendone(&list, buf, 1);
-	}
+	return 0;
+}
+
+
+/*  */
+void tou_block_reader_destroy(tou_block_reader* reader)
+{
+	if (!reader)
+		return;
+	free(reader->mem);
+	reader->mem = NULL;
+	reader->buffer = NULL;
+}
+
+
+/*  */
+void tou_block_reader_set_fp(tou_block_reader* reader, FILE* fp)
+{
+	reader->fp = fp;
+	reader->fd = -1;
+	reader->positional = 0;
+	reader->offset = 0;
+	reader->len = 0;
+	reader->error = 0;
+}
+
 
-	return list;//tou_llist_get_tail(list);
+#ifndef _WIN32
+/*  */
+void tou_block_reader_set_fd(tou_block_reader* reader, int fd, int positional, unsigned long long offset)
+{
+	reader->fp = NULL;
+	reader->fd = fd;
+	reader->positional = (positional != 0);
+	reader->offset = positional ? offset : 0;
+	reader->len = 0;
+	reader->error = 0;
 }
+#endif
 
 
 /*  */
-char* tou_sappend(char* dst, char* src)
+size_t tou_block_reader_read(tou_block_reader* reader)
 {
-	size_t dst_len = tou_strlen(dst);
-	size_t src_len = tou_strlen(src);
+	size_t len = 0;
 
-	size_t new_size = dst_len + src_len + 1;
-	dst = realloc(dst, new_size);
-	tou_strlcpy(dst + dst_len, src, new_size);
+	if (reader->fp) {
+		len = fread(reader->buffer, 1, reader->blocksize, reader->fp);
+		if (len < reader->blocksize && ferror(reader->fp))
+			reader->error = 1;
 
-	return dst;
+	}
+#ifndef _WIN32
+	else if (reader->fd >= 0) {
+		while (len < reader->blocksize) {
+			ssize_t cnt;
+			if (reader->positional) {
+#ifdef _TOU_HAVE_PREAD
+				cnt = pread(reader->fd, reader->buffer + len, reader->blocksize - len, (off_t)(reader->offset + len));
+#else
+				if (lseek(reader->fd, (off_t)(reader->offset + len), SEEK_SET) < 0)
+					cnt = -1;
+				else
+					cnt = read(reader->fd, reader->buffer + len, reader->blocksize - len);
+#endif
+			} else {
+				cnt = read(reader->fd, reader->buffer + len, reader->blocksize - len);
+			}
+
+			if (cnt < 0) {
+				if (errno == EINTR)
+					continue;
+				TOU_PRINTD("[block_reader_read] read failed\n");
+				reader->error = 1;
+				break;
+			}
+			if (cnt == 0)
+				break;
+			len += (size_t)cnt;
+		}
+	}
+#endif
+
+	reader->offset += len;
+	reader->len = len;
+	return len;
 }
 
 
 /*  */
-char* tou_sappendch(char* dst, char src)
+size_t tou_block_reader_run(tou_block_reader* reader, tou_func3 cb, void* userdata)
 {
-	size_t dst_len = tou_strlen(dst);
+	size_t bytes_read = 0;
+	size_t cnt;
 
-	size_t new_size = dst_len + 1 + 1;
-	dst = realloc(dst, new_size);
+	while ((cnt = tou_block_reader_read(reader)) > 0) {
+		bytes_read += cnt;
 
-	*(dst + dst_len) = src;
-	*(dst + dst_len + 1) = '\0';
+		if (cb) {
+			if ((ssize_t)cb(reader->buffer, (void*) cnt, userdata) == (ssize_t)TOU_BREAK) {
+				// User stopped iteration
+				TOU_PRINTD("[block_reader_run] iteration aborted.\n");
+				break;
+			}
+		}
+	}
 
-	return dst;
+	return bytes_read;
 }
 
 
-/*  */
-char* tou_sprepend(char* dst, char* src)
+#ifndef TOU_NO_THREADS
+/* Ring of blocks shared by the read-ahead thread and the consumer */
+typedef struct {
+	tou_block_reader* reader;
+	char** bufs;
+	size_t* lens;
+	int n;
+	int head; // next slot to deliver
+	int filled; // slots holding undelivered blocks
+	char done; // reader reached the end of input
+	char stop; // consumer returned TOU_BREAK
+	_tou_mutex_t lock;
+	_tou_cond_t cond;
+} _tou_readahead_t;
+
+
+/* Background thread: fills free slots in order until the end of input or a stop */
+static void* _tou_readahead_worker(void* arg)
 {
-	size_t dst_len = tou_strlen(dst);
-	size_t src_len = tou_strlen(src);
+	_tou_readahead_t* ra = (_tou_readahead_t*)arg;
+	int tail = 0;
 
-	char* new_mem = malloc(dst_len + src_len + 1);
+	while (1) {
+		_tou_mutex_lock(&ra->lock);
+		while (ra->filled == ra->n && !ra->stop)
+			_tou_cond_wait(&ra->cond, &ra->lock);
+		int stop = ra->stop;
+		_tou_mutex_unlock(&ra->lock);
+		if (stop)
+			break;
 
-	memcpy(new_mem,           src, src_len);
-	memcpy(new_mem + src_len, dst, dst_len + 1); // copy \0 too
+		// The slot is free, so only this thread touches it until it's queued
+		ra->reader->buffer = ra->bufs[tail];
+		size_t len = tou_block_reader_read(ra->reader);
 
-	return new_mem;
+		_tou_mutex_lock(&ra->lock);
+		if (len == 0) {
+			ra->done = 1;
+		} else {
+			ra->lens[tail] = len;
+			ra->filled++;
+		}
+		_tou_cond_broadcast(&ra->cond);
+		_tou_mutex_unlock(&ra->lock);
+
+		if (len == 0)
+			break;
+		tail = (tail + 1) % ra->n;
+	}
+
+	return NULL;
 }
+#endif
 
 
 /*  */
-char* tou_sprependch(char* dst, char src)
+size_t tou_block_reader_run_ahead(tou_block_reader* reader, int nbuffers, tou_func3 cb, void* userdata)
 {
-	size_t dst_len = tou_strlen(dst);
+#ifdef TOU_NO_THREADS
+	(void)nbuffers;
+	return tou_block_reader_run(reader, cb, userdata);
+#else
+	if (nbuffers <= 0)
+		nbuffers = 2;
+	if (nbuffers == 1)
+		return tou_block_reader_run(reader, cb, userdata);
+
+	_tou_readahead_t ra;
+	ra.reader = reader;
+	ra.n = nbuffers;
+	ra.head = 0;
+	ra.filled = 0;
+	ra.done = 0;
+	ra.stop = 0;
+
+	char* own_buffer = reader->buffer;
+	unsigned long long start = reader->offset;
+	void** mems = calloc((size_t)nbuffers, sizeof *mems);
+	ra.bufs = calloc((size_t)nbuffers, sizeof *ra.bufs);
+	ra.lens = calloc((size_t)nbuffers, sizeof *ra.lens);
+
+	int ok = (mems && ra.bufs && ra.lens);
+	if (ok) {
+		ra.bufs[0] = own_buffer;
+		for (int i = 1; i < nbuffers && ok; i++)
+			ok = (ra.bufs[i] = _tou_block_alloc(reader->blocksize, &mems[i])) != NULL;
+	}
 
-	char* new_mem = malloc(dst_len + 1 + 1);
+	_tou_thread_t thread;
+	if (ok) {
+		_tou_mutex_init(&ra.lock);
+		_tou_cond_init(&ra.cond);
+		if (!_tou_thread_create(&thread, _tou_readahead_worker, &ra)) {
+			_tou_cond_destroy(&ra.cond);
+			_tou_mutex_destroy(&ra.lock);
+			ok = 0;
+		}
+	}
 
-	*new_mem = src;
-	memcpy(new_mem + 1, dst, dst_len + 1); // don't forget to copy \0 too
+	if (!ok) {
+		TOU_PRINTD("[block_reader_run_ahead] cannot start read-ahead, reading serially\n");
+		for (int i = 0; mems && i < nbuffers; i++)
+			free(mems[i]);
+		free(mems);
+		free(ra.bufs);
+		free(ra.lens);
+		return tou_block_reader_run(reader, cb, userdata);
+	}
 
-	return new_mem;
+	size_t bytes_read = 0;
+	while (1) {
+		_tou_mutex_lock(&ra.lock);
+		while (ra.filled == 0 && !ra.done)
+			_tou_cond_wait(&ra.cond, &ra.lock);
+		if (ra.filled == 0) { // done and drained
+			_tou_mutex_unlock(&ra.lock);
+			break;
+		}
+		int slot = ra.head;
+		size_t len = ra.lens[slot];
+		_tou_mutex_unlock(&ra.lock);
+
+		bytes_read += len;
+		int stop = (cb && (ssize_t)cb(ra.bufs[slot], (void*) len, userdata) == (ssize_t)TOU_BREAK);
+
+		_tou_mutex_lock(&ra.lock);
+		ra.head = (ra.head + 1) % ra.n;
+		ra.filled--;
+		if (stop)
+			ra.stop = 1;
+		_tou_cond_broadcast(&ra.cond);
+		_tou_mutex_unlock(&ra.lock);
+
+		if (stop) {
+			TOU_PRINTD("[block_reader_run_ahead] iteration aborted.\n");
+			break;
+		}
+	}
+
+	_tou_thread_join(thread);
+	_tou_cond_destroy(&ra.cond);
+	_tou_mutex_destroy(&ra.lock);
+
+	// Blocks read ahead but never delivered don't count
+	reader->buffer = own_buffer;
+	reader->len = 0;
+	if (reader->positional)
+		reader->offset = start + bytes_read;
+
+	for (int i = 0; i < nbuffers; i++)
+		free(mems[i]);
+	free(mems);
+	free(ra.bufs);
+	free(ra.lens);
+	return bytes_read;
+#endif
 }
 
 
 /*  */
-char* tou_sreplace(char* str, char* repl_str, char* with_str)
+size_t tou_read_fp_in_blocks(FILE* fp, size_t blocksize, tou_func3 cb, void* userdata)
 {
-	return tou_sreplace_n(str, repl_str, with_str, NULL);
+	tou_block_reader reader;
+	if (tou_block_reader_init(&reader, blocksize, NULL) != 0)
+		return 0;
+
+	tou_block_reader_set_fp(&reader, fp);
+	size_t bytes_read = tou_block_reader_run(&reader, cb, userdata);
+
+	tou_block_reader_destroy(&reader);
+	return bytes_read;
 }
 
 
 /*  */
-char* tou_sreplace_n(char* str, char* repl_str, char* with_str, size_t* len_ptr)
+size_t tou_read_fp_in_blocks_ahead(FILE* fp, size_t blocksize, int nbuffers, tou_func3 cb, void* userdata)
 {
-	if (!str || !repl_str) {
-		TOU_PRINTD("[tou_sreplace_n] string or replace string NULL\n");
-		return NULL;
-	}
+	tou_block_reader reader;
+	if (tou_block_reader_init(&reader, blocksize, NULL) != 0)
+		return 0;
 
-	size_t true_len = tou_strlen(str);
-	size_t repl_len = tou_strlen(repl_str);
-	size_t with_len = tou_strlen(with_str);
-	
-	size_t len = 0;
-	if (len_ptr != NULL) {
-		len = *len_ptr;
-	}
-	if (len == 0 || len > true_len)
-		len = true_len;
+	tou_block_reader_set_fp(&reader, fp);
+	size_t bytes_read = tou_block_reader_run_ahead(&reader, nbuffers, cb, userdata);
 
-	char tmp_replaced_ch = '\0';
-	if (len < true_len) {
-		tmp_replaced_ch = str[len];
-		str[len] = '\0';
-	}
+	tou_block_reader_destroy(&reader);
+	return bytes_read;
+}
 
-	char* search_ptr = str;
-	char* dst = NULL;
-	char* tmp_dst; // used when realloc'ing dst & when iterating last part
-	size_t current_size = 0;
-	const int with_alloc_mult = 4; // prealloc for more than one and shrink in the end?
-	
-	size_t copydiff = 0;
-	char* next_with = NULL;
 
-	while ((next_with = tou_sfind(search_ptr, repl_str)) != NULL)
-	{
-		copydiff = next_with - search_ptr;
+#ifndef TOU_NO_THREADS
+/*
+	Reorder buffer of the parallel block reader: block i lives in slot
+	i % n_slots from being read until it is reduced, so slots free up
+	in file order.
+*/
+typedef struct {
+	char** bufs;
+	size_t* lens;
+	void** results;
+	char* mapped;
+	size_t n_slots;
+	size_t next_read; // blocks read so far
+	size_t next_map; // next block a worker takes
+	size_t next_reduce; // next block to hand to reduce_cb
+	char eof;
+	char stop;
+	tou_func3 map_cb;
+	void* userdata;
+	_tou_mutex_t lock;
+	_tou_cond_t cond;
+} _tou_pblocks_t;
+
+
+/* Worker: maps blocks in the order they were read until there are no more */
+static void* _tou_pblocks_worker(void* arg)
+{
+	_tou_pblocks_t* pb = (_tou_pblocks_t*)arg;
 
-		if ((tmp_dst = realloc(dst, current_size + copydiff + with_len*with_alloc_mult + 1)) == NULL) {
-			TOU_PRINTD("[tou_sreplace_n] realloc failed (%zu bytes)\n", current_size + copydiff + with_len*with_alloc_mult + 1);
-			if (dst != NULL) // Would be NULL if this was the first replace
-				*(dst + current_size) = '\0'; // needed?
+	_tou_mutex_lock(&pb->lock);
+	while (1) {
+		while (!pb->stop && !pb->eof && pb->next_map == pb->next_read)
+			_tou_cond_wait(&pb->cond, &pb->lock);
+		if (pb->stop || pb->next_map == pb->next_read)
 			break;
-		}
-		dst = tmp_dst;
-
-		memcpy(dst + current_size,            search_ptr, copydiff);
-		memcpy(dst + current_size + copydiff, with_str,   with_len);
-		// *(dst + current_size + copydiff + with_len) = '\0';
-		
-		current_size += copydiff + with_len;
-		search_ptr   += copydiff + repl_len;
-	}
-
-	// Calc size of last one + remainder of source
-	size_t rest = tou_strlen(search_ptr); // last part + non-searched remainder since replaced char was returned to place
-	if ((tmp_dst = realloc(dst, current_size + rest + 1)) == NULL) {
-		TOU_PRINTD("[tou_sreplace_n] last part realloc failed (%zu)\n", current_size + rest + 1);
-		return dst;
-	}
-	dst = tmp_dst;
 
-	// Copy the remaining unmodified part from search_ptr to (tmp_)dst
-	tmp_dst = dst + current_size;
-	while (*search_ptr)
-		*(tmp_dst++) = *(search_ptr++);
-	*tmp_dst = '\0';
-	current_size += rest;
+		size_t slot = pb->next_map++ % pb->n_slots;
+		_tou_mutex_unlock(&pb->lock);
 
-	// Restore replaced char if it was needed
-	if (tmp_replaced_ch != '\0')
-		str[len] = tmp_replaced_ch;
+		void* result = pb->map_cb ? pb->map_cb(pb->bufs[slot], (void*) pb->lens[slot], pb->userdata) : NULL;
 
-	// Resize to fit if larger (?)
-	tmp_dst = realloc(dst, current_size + 1);
-	if (tmp_dst) {
-		// realloc succeded
-		if (len_ptr) {
-			*len_ptr = current_size;
-		}
-		return tmp_dst;
+		_tou_mutex_lock(&pb->lock);
+		pb->results[slot] = result;
+		pb->mapped[slot] = 1;
+		_tou_cond_broadcast(&pb->cond);
 	}
+	_tou_mutex_unlock(&pb->lock);
 
-	// realloc failed
-	if (len_ptr) {
-		*len_ptr = tou_strlen(dst);
-	}
-	return dst;
+	return NULL;
 }
+#endif
 
 
-////////////////////////////////////////
-///              Files               ///
-////////////////////////////////////////
+/* Single-threaded version: map and reduce each block right after reading it */
+typedef struct {
+	tou_func3 map_cb;
+	tou_func3 reduce_cb;
+	void* userdata;
+	size_t index;
+} _tou_pblocks_serial_t;
 
 
 /*  */
-size_t tou_read_fp_in_blocks(FILE* fp, size_t blocksize, tou_func3 cb, void* userdata)
+static void* _tou_pblocks_serial_cb(void* blockdata, void* len, void* userdata)
 {
-	// Clamp blocksize to TOU_DEFAULT_BLOCKSIZE if not in following range:
-	if (blocksize < 1 || blocksize > 0xFFFFFF) {
-		blocksize = TOU_DEFAULT_BLOCKSIZE;
-		TOU_PRINTD("[tou_read_fp_in_blocks] clamping blocksize to " TOU_MSTR(TOU_DEFAULT_BLOCKSIZE) "\n");
-	}
+	_tou_pblocks_serial_t* ps = (_tou_pblocks_serial_t*)userdata;
 
-	size_t curr_bufsize = 0;
-	char blockbuf[blocksize];
-	size_t bytes_read = 0;
+	void* result = ps->map_cb ? ps->map_cb(blockdata, len, ps->userdata) : NULL;
+	size_t index = ps->index++;
 
-	while (1) {
-		// Clear buf
-		memset(blockbuf, 0, blocksize);
+	if (ps->reduce_cb && (ssize_t)ps->reduce_cb(result, (void*) index, ps->userdata) == (ssize_t)TOU_BREAK)
+		return (void*)TOU_BREAK;
+	return (void*)TOU_CONTINUE;
+}
 
-		// Load data into buf
-		size_t cnt = fread(blockbuf, 1, blocksize, fp);
-		if (cnt <= 0)
-			break;
 
-		// Store real read length
-		bytes_read += cnt;
+/*  */
+size_t tou_read_fp_in_blocks_parallel(FILE* fp, size_t blocksize, tou_func3 map_cb, tou_func3 reduce_cb, void* userdata, int nthreads)
+{
+	if (blocksize == 0 || blocksize == (size_t)-1)
+		blocksize = TOU_DEFAULT_BLOCKSIZE; // the slots are allocated here too
+	if (nthreads <= 0)
+		nthreads = _tou_cpu_count();
 
-		// Do the useful things
-		if (cb) {
-			if ((ssize_t)cb(blockbuf, (void*) cnt, userdata) == (ssize_t)TOU_BREAK) {
-				// User stopped iteration
-				TOU_PRINTD("[tou_read_fp_in_blocks] iteration aborted.\n");
+	tou_block_reader reader;
+	if (tou_block_reader_init(&reader, blocksize, NULL) != 0)
+		return 0;
+	tou_block_reader_set_fp(&reader, fp);
+
+#ifndef TOU_NO_THREADS
+	_tou_pblocks_t pb;
+	memset(&pb, 0, sizeof pb);
+	pb.n_slots = (size_t)nthreads * 2 + 1;
+	pb.map_cb = map_cb;
+	pb.userdata = userdata;
+
+	void** mems = NULL;
+	_tou_thread_t* threads = NULL;
+	int started = 0;
+
+	if (nthreads > 1) {
+		mems = calloc(pb.n_slots, sizeof *mems);
+		pb.bufs = calloc(pb.n_slots, sizeof *pb.bufs);
+		pb.lens = calloc(pb.n_slots, sizeof *pb.lens);
+		pb.results = calloc(pb.n_slots, sizeof *pb.results);
+		pb.mapped = calloc(pb.n_slots, sizeof *pb.mapped);
+		threads = malloc((size_t)nthreads * sizeof *threads);
+
+		int ok = (mems && pb.bufs && pb.lens && pb.results && pb.mapped && threads);
+		if (ok) {
+			pb.bufs[0] = reader.buffer;
+			for (size_t i = 1; i < pb.n_slots && ok; i++)
+				ok = (pb.bufs[i] = _tou_block_alloc(blocksize, &mems[i])) != NULL;
+		}
+
+		if (ok) {
+			_tou_simd_init(); // map_cb may search from several workers at once
+			_tou_mutex_init(&pb.lock);
+			_tou_cond_init(&pb.cond);
+			while (started < nthreads && _tou_thread_create(&threads[started], _tou_pblocks_worker, &pb))
+				started++;
+			if (started == 0) {
+				_tou_cond_destroy(&pb.cond);
+				_tou_mutex_destroy(&pb.lock);
+			}
+		}
+		TOU_PRINTD("[read_fp_in_blocks_parallel] %zu slots of %zu bytes on %d threads\n", pb.n_slots, blocksize, started);
+	}
+
+	if (started > 0) {
+		char* own_buffer = reader.buffer;
+		size_t bytes_read = 0;
+
+		while (1) {
+			// Refill every free slot; only this thread reads, and a free slot isn't touched by workers
+			while (!pb.eof && pb.next_read - pb.next_reduce < pb.n_slots) {
+				size_t slot = pb.next_read % pb.n_slots;
+				reader.buffer = pb.bufs[slot];
+				size_t len = tou_block_reader_read(&reader);
+
+				_tou_mutex_lock(&pb.lock);
+				if (len == 0) {
+					pb.eof = 1;
+				} else {
+					pb.lens[slot] = len;
+					pb.mapped[slot] = 0;
+					pb.next_read++;
+				}
+				_tou_cond_broadcast(&pb.cond);
+				_tou_mutex_unlock(&pb.lock);
+			}
+
+			// Reduce the oldest block once it's mapped
+			_tou_mutex_lock(&pb.lock);
+			if (pb.next_reduce == pb.next_read) { // eof and everything delivered
+				_tou_mutex_unlock(&pb.lock);
+				break;
+			}
+			size_t index = pb.next_reduce;
+			size_t slot = index % pb.n_slots;
+			while (!pb.mapped[slot])
+				_tou_cond_wait(&pb.cond, &pb.lock);
+			void* result = pb.results[slot];
+			size_t len = pb.lens[slot];
+			_tou_mutex_unlock(&pb.lock);
+
+			bytes_read += len;
+			int stop = (reduce_cb && (ssize_t)reduce_cb(result, (void*) index, userdata) == (ssize_t)TOU_BREAK);
+
+			_tou_mutex_lock(&pb.lock);
+			pb.next_reduce++;
+			if (stop)
+				pb.stop = 1;
+			_tou_cond_broadcast(&pb.cond);
+			_tou_mutex_unlock(&pb.lock);
+
+			if (stop) {
+				TOU_PRINTD("[read_fp_in_blocks_parallel] iteration aborted.\n");
 				break;
 			}
 		}
+
+		// Workers exit once they see eof with nothing left to map, or stop
+		_tou_mutex_lock(&pb.lock);
+		pb.stop = 1;
+		_tou_cond_broadcast(&pb.cond);
+		_tou_mutex_unlock(&pb.lock);
+		for (int i = 0; i < started; i++)
+			_tou_thread_join(threads[i]);
+		_tou_cond_destroy(&pb.cond);
+		_tou_mutex_destroy(&pb.lock);
+
+		reader.buffer = own_buffer;
+		for (size_t i = 0; i < pb.n_slots; i++)
+			free(mems[i]);
+		free(mems);
+		free(pb.bufs);
+		free(pb.lens);
+		free(pb.results);
+		free(pb.mapped);
+		free(threads);
+		tou_block_reader_destroy(&reader);
+		return bytes_read;
 	}
 
+	for (size_t i = 0; mems && i < pb.n_slots; i++)
+		free(mems[i]);
+	free(mems);
+	free(pb.bufs);
+	free(pb.lens);
+	free(pb.results);
+	free(pb.mapped);
+	free(threads);
+#endif
+
+	_tou_pblocks_serial_t ps = { map_cb, reduce_cb, userdata, 0 };
+	size_t bytes_read = tou_block_reader_run(&reader, _tou_pblocks_serial_cb, &ps);
+
+	tou_block_reader_destroy(&reader);
 	return bytes_read;
 }
 
 
+/* Makes room for `extra` more bytes plus a '\0' in `data`, growing it geometrically */
+static int _tou_block_store_reserve(tou_block_store_struct* data, size_t extra)
+{
+	size_t need = data->size + extra + 1;
+	if (need <= data->capacity && data->buffer)
+		return 0;
+
+	size_t cap = data->capacity * 2;
+	if (cap < need)
+		cap = need;
+	if (cap < TOU_DEFAULT_BLOCKSIZE)
+		cap = TOU_DEFAULT_BLOCKSIZE;
+
+	char* new_buffer = realloc(data->buffer, cap);
+	if (!new_buffer)
+		return -1;
+	data->buffer = new_buffer;
+	data->capacity = cap;
+	return 0;
+}
+
+
 /*  */
 void* tou_block_store_cb(void* blockdata, void* len, void* userdata)
 {
@@ -2267,17 +8042,14 @@ void* tou_block_store_cb(void* blockdata, void* len, void* userdata)
 	TOU_PRINTD("\n[tou_block_store_cb] Block\n=====\n%.*s (...first %d bytes)\n===== (%zu)\n", (size>64)?64:size, block, (size>64)?64:size, size);
 
 	if (size > 0) {
-		char* new_buffer = realloc(data->buffer, data->size + size + 1); // accomodate \0
-		if (!new_buffer){ 
+		if (_tou_block_store_reserve(data, size) != 0) {
 			TOU_PRINTD("[tou_block_store_cb] cannot realloc memory\n");
-			// return (void*) TOU_BREAK;
-		} else {
-			memcpy(new_buffer + data->size, block, size);
-			*(new_buffer + data->size + size) = '\0';
-			data->buffer = new_buffer;
-			data->size += size;
-			TOU_PRINTD("[tou_block_store_cb] appended block {size=%zu}\n", data->size);
+			return (void*) TOU_BREAK;
 		}
+		memcpy(data->buffer + data->size, block, size);
+		data->size += size;
+		data->buffer[data->size] = '\0';
+		TOU_PRINTD("[tou_block_store_cb] appended block {size=%zu}\n", data->size);
 	}
 	
 	return (void*)TOU_CONTINUE;
@@ -2306,6 +8078,19 @@ char* tou_read_file(const char* filename, size_t* read_len)
 }
 
 
+/* Bytes left in `fp` if it is seekable, otherwise 0 (pipes, terminals) */
+static size_t _tou_fp_remaining(FILE* fp)
+{
+	long cur = ftell(fp);
+	if (cur < 0 || fseek(fp, 0, SEEK_END) != 0)
+		return 0;
+	long end = ftell(fp);
+	if (fseek(fp, cur, SEEK_SET) != 0 || end <= cur)
+		return 0;
+	return (size_t)(end - cur);
+}
+
+
 /*  */
 char* tou_read_fp(FILE* fp, size_t* read_len)
 {
@@ -2314,11 +8099,44 @@ char* tou_read_fp(FILE* fp, size_t* read_len)
 
 	TOU_PRINTD("[read_fp] reading from: FILE* %p\n", fp);
 
-	// char* read = tou_read_fp_in_blocks(fp, read_len, -1, NULL, NULL); // default block size, without function
-	// tou_read_fp_in_blocks -> (FILE* fp, size_t* read_len, size_t blocksize, tou_func3 cb, void* userdata)
-	tou_block_store_struct tmp = {NULL, 0};
-	tou_read_fp_in_blocks(fp, TOU_DEFAULT_BLOCKSIZE, tou_block_store_cb, &tmp);
-	
+	tou_block_store_struct tmp = {NULL, 0, 0};
+
+	// Known size: one exact allocation and one fread() (which stdio passes
+	// straight to the OS since it's larger than its own buffer)
+	size_t expected = _tou_fp_remaining(fp);
+	if (expected > 0 && expected < SIZE_MAX && (tmp.buffer = malloc(expected + 1)) != NULL) {
+		tmp.capacity = expected + 1;
+		tmp.size = fread(tmp.buffer, 1, expected, fp);
+		tmp.buffer[tmp.size] = '\0';
+		TOU_PRINTD("[read_fp] read %zu of %zu expected bytes\n", tmp.size, expected);
+
+		int c = (tmp.size == expected) ? fgetc(fp) : EOF;
+		if (c == EOF)
+			goto done;
+		ungetc(c, fp); // file grew meanwhile; read the rest below
+	}
+
+	// Unknown size: read straight into the free space, doubling it as needed
+	while (1) {
+		if (_tou_block_store_reserve(&tmp, TOU_DEFAULT_BLOCKSIZE) != 0) {
+			TOU_PRINTD("[read_fp] cannot realloc memory\n");
+			break;
+		}
+		size_t cnt = fread(tmp.buffer + tmp.size, 1, tmp.capacity - 1 - tmp.size, fp);
+		tmp.size += cnt;
+		tmp.buffer[tmp.size] = '\0';
+		if (cnt == 0)
+			break;
+	}
+
+	// Give back what the doubling overshot
+	if (tmp.buffer && tmp.capacity > tmp.size + 1) {
+		char* shrunk = realloc(tmp.buffer, tmp.size + 1);
+		if (shrunk)
+			tmp.buffer = shrunk;
+	}
+
+done:
 	TOU_PRINTD("[read_fp] finished reading.\n");
 
 	if (read_len)
@@ -2328,6 +8146,167 @@ char* tou_read_fp(FILE* fp, size_t* read_len)
 }
 
 
+#ifndef _WIN32
+/* Reads everything left in `fd` into a growing, '\0'-terminated heap buffer */
+static char* _tou_read_fd(int fd, size_t* read_len)
+{
+	size_t cap = 64 * 1024;
+	size_t len = 0;
+	char* buf = malloc(cap + 1);
+	if (!buf)
+		return NULL;
+
+	while (1) {
+		if (len == cap) {
+			char* tmp = realloc(buf, cap * 2 + 1);
+			if (!tmp) {
+				free(buf);
+				return NULL;
+			}
+			buf = tmp;
+			cap *= 2;
+		}
+		ssize_t cnt = read(fd, buf + len, cap - len);
+		if (cnt < 0) {
+			if (errno == EINTR)
+				continue;
+			free(buf);
+			return NULL;
+		}
+		if (cnt == 0)
+			break;
+		len += (size_t)cnt;
+	}
+
+	buf[len] = '\0';
+	*read_len = len;
+	return buf;
+}
+#endif
+
+
+/*  */
+int tou_map_file(const char* filename, tou_mapped_file* file, int flags)
+{
+	if (!file)
+		return -1;
+	file->data = NULL;
+	file->len = 0;
+	file->mapped = 0;
+
+	if (!filename || strlen(filename) == 0 || strcmp("stdin", filename) == 0) { // stdin
+		size_t len = 0;
+		char* data = tou_read_fp(stdin, &len);
+		if (!data && ferror(stdin))
+			return -1;
+		file->data = data;
+		file->len = len;
+		return 0;
+	}
+
+#ifdef _WIN32
+	(void)flags;
+	size_t len = 0;
+	FILE* fp = fopen(filename, "rb");
+	if (!fp) {
+		TOU_PRINTD("[map_file] cannot open '%s'\n", filename);
+		return -1;
+	}
+	char* data = tou_read_fp(fp, &len);
+	int err = ferror(fp);
+	fclose(fp);
+	if (err) {
+		free(data);
+		return -1;
+	}
+	file->data = data;
+	file->len = len;
+	return 0;
+
+#else
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		TOU_PRINTD("[map_file] cannot open '%s'\n", filename);
+		return -1;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0) {
+		close(fd);
+		return -1;
+	}
+
+	if (!S_ISREG(st.st_mode)) { // pipe, FIFO, device: nothing to map
+		TOU_PRINTD("[map_file] '%s' is not a regular file, reading it\n", filename);
+		size_t len = 0;
+		char* data = _tou_read_fd(fd, &len);
+		close(fd);
+		if (!data)
+			return -1;
+		file->data = data;
+		file->len = len;
+		return 0;
+	}
+
+	if ((uintmax_t)st.st_size > (uintmax_t)SIZE_MAX) {
+		close(fd);
+		return -1;
+	}
+	size_t len = (size_t)st.st_size;
+	if (len == 0) { // mmap() refuses empty ranges
+		close(fd);
+		return 0;
+	}
+
+	int prot = PROT_READ | ((flags & TOU_MAP_WRITABLE) ? PROT_WRITE : 0);
+	void* addr = mmap(NULL, len, prot, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps its own reference
+	if (addr == MAP_FAILED) {
+		TOU_PRINTD("[map_file] mmap of '%s' failed\n", filename);
+		return -1;
+	}
+
+	// Hints are only advisory, so failures are ignored
+#if defined(MADV_SEQUENTIAL)
+	if (flags & TOU_MAP_SEQUENTIAL)
+		madvise(addr, len, MADV_SEQUENTIAL);
+	if (flags & TOU_MAP_WILLNEED)
+		madvise(addr, len, MADV_WILLNEED);
+#elif defined(POSIX_MADV_SEQUENTIAL)
+	if (flags & TOU_MAP_SEQUENTIAL)
+		posix_madvise(addr, len, POSIX_MADV_SEQUENTIAL);
+	if (flags & TOU_MAP_WILLNEED)
+		posix_madvise(addr, len, POSIX_MADV_WILLNEED);
+#endif
+
+	TOU_PRINTD("[map_file] mapped '%s' {len=%zu}\n", filename, len);
+	file->data = addr;
+	file->len = len;
+	file->mapped = 1;
+	return 0;
+#endif
+}
+
+
+/*  */
+void tou_unmap_file(tou_mapped_file* file)
+{
+	if (!file)
+		return;
+
+#ifndef _WIN32
+	if (file->mapped && file->data)
+		munmap(file->data, file->len);
+	else
+#endif
+		free(file->data);
+
+	file->data = NULL;
+	file->len = 0;
+	file->mapped = 0;
+}
+
+
 /*  */
 int tou_disable_stdout()
 {
@@ -3054,7 +9033,12 @@ tou_llist_t* tou_ini_parse_buffer(char* buf)
 	const char* nls[] = {"\r\n", "\n"};
 	int found_idx;
 
-	while ((pos = tou_sfind_multiple(buf, nls, 2, &found_idx)) != NULL)
+	tou_kwset* nl_set = tou_kwset_new(nls, 2);
+	if (nl_set == NULL)
+		return NULL;
+	char* buf_end = buf + strlen(buf);
+
+	while ((pos = tou_kwset_find_n(nl_set, buf, buf_end - buf, &found_idx)) != NULL)
 	{
 		line_no++;
 		*pos = '\0';
@@ -3063,11 +9047,13 @@ tou_llist_t* tou_ini_parse_buffer(char* buf)
 		if (status == TOU_BREAK) {
 			TOU_PRINTD("Invalid line encountered while parsing (line %zu): %s\n", line_no, buf);
 			tou_ini_destroy(inicontents);
+			tou_kwset_destroy(nl_set);
 			return NULL;
 		}
 
-		buf = pos + strlen(nls[found_idx]);
+		buf = pos + nl_set->kwd_lens[found_idx];
 	}
+	tou_kwset_destroy(nl_set);
 
 	// Last line
 	if (tou_strlen(buf) > 0) {
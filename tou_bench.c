@@ -0,0 +1,1009 @@
+// Microbenchmarks; build and run with `just bench`.
+// Every group times the library function against what it replaced
+// (copied here as old_*) and, where one exists, against libc.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ctype.h>
+
+#define TOU_IMPLEMENTATION
+#define TOU_DBG 0
+#include "tou.h"
+
+// Keeps results alive so the compiler can't drop the timed calls
+static volatile size_t bench_sink;
+
+
+/* Monotonic time in seconds */
+static double bench_now(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, now;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/* Prints one result row; `bytes` is how much input a single run touched */
+static void bench_report(const char* name, double secs, size_t runs, size_t bytes)
+{
+	printf("  %-28s %10.1f ns/run %9.2f GB/s\n", name,
+		secs * 1e9 / runs, (double)bytes * runs / secs / 1e9);
+}
+
+/* Times `expr` repeated `runs` times */
+#define BENCH(name, runs, bytes, expr) do { \
+	double _t0 = bench_now(); \
+	for (size_t _r = 0; _r < (runs); _r++) { \
+		bench_sink += (size_t)(expr); \
+	} \
+	bench_report((name), bench_now() - _t0, (runs), (bytes)); \
+} while (0)
+
+
+///////////////////////////////////////
+// Previous implementations, for reference
+
+static char* old_strchr(const char* src, int ch)
+{
+	while (*src) {
+		if (*src == (char)ch)
+			return (char*)src;
+		src++;
+	}
+	return (ch == '\0') ? (char*)src : NULL;
+}
+
+static char* old_strrchr(const char* src, int ch)
+{
+	char* pos = NULL;
+	while (*src) {
+		if (*src == (char)ch)
+			pos = (char*)src;
+		src++;
+	}
+	return (ch == '\0') ? (char*)src : pos;
+}
+
+static char* old_trim_front_pure(char* str)
+{
+	while (*str != '\0' && TOU_IS_BLANK(*str))
+		str++;
+	return str;
+}
+
+static char* old_trim_back_pure(char* str)
+{
+	char* ptr = (str + strlen(str) - 1);
+	while (ptr >= str && TOU_IS_BLANK(*ptr))
+		ptr--;
+	return ptr + 1;
+}
+
+static char* old_slower(char* str)
+{
+	for (char* ptr = str; *ptr; ptr++)
+		*ptr = tolower((unsigned char)*ptr);
+	return str;
+}
+
+static char* old_replace_ch(char* ss, char oldch, char newch)
+{
+	char* ptr = old_strchr(ss, oldch);
+	while (ptr) {
+		*ptr = newch;
+		ptr = old_strchr(ptr + 1, oldch);
+	}
+	return ss;
+}
+
+/* Realloc-per-match replace that sreplace_n used before */
+static char* old_sreplace(const char* str, const char* repl_str, const char* with_str)
+{
+	size_t len = strlen(str);
+	size_t repl_len = strlen(repl_str);
+	size_t with_len = strlen(with_str);
+	const char* search_ptr = str;
+	char* dst = NULL;
+	size_t current_size = 0;
+	const char* next_with;
+
+	while ((next_with = tou_sfind_n(search_ptr, repl_str, str + len - search_ptr)) != NULL) {
+		size_t copydiff = next_with - search_ptr;
+		dst = realloc(dst, current_size + copydiff + with_len * 4 + 1);
+		memcpy(dst + current_size, search_ptr, copydiff);
+		memcpy(dst + current_size + copydiff, with_str, with_len);
+		current_size += copydiff + with_len;
+		search_ptr += copydiff + repl_len;
+	}
+
+	size_t rest = strlen(search_ptr);
+	dst = realloc(dst, current_size + rest + 1);
+	char* tmp_dst = dst + current_size;
+	while (*search_ptr)
+		*(tmp_dst++) = *(search_ptr++);
+	*tmp_dst = '\0';
+	return realloc(dst, current_size + rest + 1);
+}
+
+/* One search per token, as single byte splits used to go (through memchr) */
+static size_t old_split_count(const char* str, size_t len, char delim)
+{
+	const char* end = str + len;
+	const char* p = str;
+	const char* found;
+	size_t n = 0;
+
+	while ((found = memchr(p, delim, end - p)) != NULL) {
+		n++;
+		p = found + 1;
+	}
+	return n + (p < end);
+}
+
+/* tou_split as it was before single byte delimiters got bulk indexed */
+static size_t old_split(const char* str, char delim)
+{
+	size_t len = strlen(str);
+	const char* end = str + len;
+	const char* p = str;
+	const char* found;
+	tou_llist_t* list = NULL;
+
+	while ((found = memchr(p, delim, end - p)) != NULL) {
+		char* buf = malloc(found - p + 1);
+		memcpy(buf, p, found - p);
+		buf[found - p] = '\0';
+		tou_llist_appendone(&list, buf, 1);
+		p = found + 1;
+	}
+	if (p < end) {
+		char* buf = malloc(end - p + 1);
+		memcpy(buf, p, end - p);
+		buf[end - p] = '\0';
+		tou_llist_appendone(&list, buf, 1);
+	}
+
+	size_t n = 0;
+	for (tou_llist_t* e = list; e; e = e->prev)
+		n++;
+	tou_llist_destroy(list);
+	return n;
+}
+
+
+/* tou_read_fp before it sized its buffer: cleared 4 KiB blocks, one exact realloc per block */
+static char* old_read_fp(FILE* fp, size_t* read_len)
+{
+	char block[4096];
+	char* buffer = NULL;
+	size_t size = 0;
+	size_t cnt;
+
+	while (1) {
+		memset(block, 0, sizeof block);
+		if ((cnt = fread(block, 1, sizeof block, fp)) == 0)
+			break;
+		char* new_buffer = realloc(buffer, size + cnt + 1);
+		if (!new_buffer)
+			break;
+		buffer = new_buffer;
+		memcpy(buffer + size, block, cnt);
+		size += cnt;
+		buffer[size] = '\0';
+	}
+
+	*read_len = size;
+	return buffer;
+}
+
+/* tou_read_fp_in_blocks with its stack VLA, cleared before every fread */
+static size_t old_read_fp_in_blocks(FILE* fp, size_t blocksize, tou_func3 cb, void* userdata)
+{
+	char blockbuf[blocksize];
+	size_t bytes_read = 0;
+
+	while (1) {
+		memset(blockbuf, 0, blocksize);
+		size_t cnt = fread(blockbuf, 1, blocksize, fp);
+		if (cnt <= 0)
+			break;
+		bytes_read += cnt;
+		if ((ssize_t)cb(blockbuf, (void*) cnt, userdata) == (ssize_t)TOU_BREAK)
+			break;
+	}
+	return bytes_read;
+}
+
+/* Keyword set matching as it was: the scan restarted after every match */
+static size_t old_sfind_all_multiple(const char* str, size_t len, const tou_kwset* set)
+{
+	size_t total = 0, pos = 0, m_off, m_len;
+	int m_idx;
+
+	while (pos < len && _tou_kwset_scan(set, (const unsigned char*)str + pos, len - pos, 1, &m_off, &m_len, &m_idx, NULL)) {
+		total++;
+		pos += m_off + m_len;
+	}
+	return total;
+}
+
+
+///////////////////////////////////////
+// Benchmarks
+
+static void bench_strchr(void)
+{
+	const size_t sizes[] = { 16, 64, 1024, 64 * 1024 };
+
+	printf("\n== strchr / strrchr ==\n");
+	for (size_t i = 0; i < TOU_ARRSIZE(sizes); i++) {
+		size_t n = sizes[i];
+		size_t runs = (256 * 1024 * 1024) / (n + 16);
+		char* s = malloc(n + 1);
+		memset(s, 'a', n);
+		s[n] = '\0';
+		s[n - 1] = 'x'; // strchr finds it at the very end
+		s[n / 16] = 'y'; // strrchr has to walk back from the end
+
+		printf(" %zu bytes:\n", n);
+		BENCH("old strchr",      runs, n, old_strchr(s, 'x'));
+		BENCH("tou_strchr",      runs, n, tou_strchr(s, 'x'));
+		BENCH("libc strchr",     runs, n, strchr(s, 'x'));
+		BENCH("old strrchr",     runs, n, old_strrchr(s, 'y'));
+		BENCH("tou_strrchr",     runs, n, tou_strrchr(s, 'y'));
+		BENCH("libc strrchr",    runs, n, strrchr(s, 'y'));
+		free(s);
+	}
+}
+
+static void bench_trim(void)
+{
+	const size_t pads[] = { 1, 8, 64, 1024 };
+	const char body[] = "key = some value";
+
+	printf("\n== trim_front_pure / trim_back_pure ==\n");
+	for (size_t i = 0; i < TOU_ARRSIZE(pads); i++) {
+		size_t pad = pads[i];
+		size_t n = 2 * pad + sizeof body - 1;
+		size_t runs = (256 * 1024 * 1024) / (n + 16);
+		char* s = malloc(n + 1);
+		for (size_t j = 0; j < pad; j++)
+			s[j] = s[n - 1 - j] = " \t\r\n"[j % 4];
+		memcpy(s + pad, body, sizeof body - 1);
+		s[n] = '\0';
+
+		printf(" %zu blanks each side:\n", pad);
+		BENCH("old trim_front_pure", runs, n, old_trim_front_pure(s));
+		BENCH("tou_trim_front_pure", runs, n, tou_trim_front_pure(s));
+		BENCH("old trim_back_pure",  runs, n, old_trim_back_pure(s));
+		BENCH("tou_trim_back_pure",  runs, n, tou_trim_back_pure(s));
+		free(s);
+	}
+}
+
+static void bench_translate(void)
+{
+	const size_t n = 16 * 1024 * 1024;
+	const size_t runs = 8;
+	char* s = malloc(n + 1);
+	const char text[] = "Lorem Ipsum,\tDOLOR sit amet\n";
+	for (size_t i = 0; i < n; i++)
+		s[i] = text[i % (sizeof text - 1)];
+	s[n] = '\0';
+
+	// Lowercase, tabs to spaces and commas to semicolons in one table
+	unsigned char table[256];
+	for (int i = 0; i < 256; i++)
+		table[i] = (i >= 'A' && i <= 'Z') ? (i | 0x20) : i;
+	table['\t'] = ' ';
+	table[','] = ';';
+
+	printf("\n== slower / replace_ch / stranslate (%zu MiB) ==\n", n >> 20);
+	BENCH("old slower",          runs, n, old_slower(s));
+	BENCH("tou_slower",          runs, n, tou_slower(s));
+	BENCH("old replace_ch",      runs, n, old_replace_ch(s, '\t', '\t'));
+	BENCH("tou_replace_ch",      runs, n, tou_replace_ch(s, '\t', '\t'));
+	BENCH("old chained (3 passes)", runs, n, old_replace_ch(old_replace_ch(old_slower(s), '\t', ' '), ',', ';'));
+	BENCH("tou chained (3 passes)", runs, n, tou_replace_ch(tou_replace_ch(tou_slower(s), '\t', ' '), ',', ';'));
+	BENCH("tou_stranslate",      runs, n, tou_stranslate(s, n, table));
+	free(s);
+}
+
+/* N prepends of a short segment, one way or the other */
+static size_t prepend_sprepend(size_t n)
+{
+	char* str = tou_strdup("file.txt");
+	for (size_t i = 0; i < n; i++) {
+		char* prev = str;
+		str = tou_sprepend(str, "seg/");
+		free(prev);
+	}
+	size_t len = strlen(str);
+	free(str);
+	return len;
+}
+
+static size_t prepend_dbuf(size_t n)
+{
+	tou_dbuf db = {0};
+	tou_dbuf_append(&db, "file.txt");
+	for (size_t i = 0; i < n; i++)
+		tou_dbuf_prependn(&db, "seg/", 4);
+	size_t len = db.len;
+	tou_dbuf_destroy(&db);
+	return len;
+}
+
+static void bench_prepend(void)
+{
+	const size_t counts[] = { 100, 1000, 10000, 50000 };
+
+	printf("\n== repeated prepends of 4 bytes ==\n");
+	for (size_t i = 0; i < TOU_ARRSIZE(counts); i++) {
+		size_t n = counts[i];
+		size_t runs = (n >= 10000) ? 3 : 200000 / n;
+
+		printf(" %zu prepends:\n", n);
+		BENCH("sprepend",      runs, 4 * n, prepend_sprepend(n));
+		BENCH("dbuf_prependn", runs, 4 * n, prepend_dbuf(n));
+	}
+}
+
+static size_t replace_free(char* str)
+{
+	size_t len = strlen(str);
+	free(str);
+	return len;
+}
+
+static void bench_sreplace(void)
+{
+	const size_t n = 16 * 1024 * 1024;
+	const size_t runs = 4;
+	char* s = malloc(n + 1);
+	char* copy = malloc(n + 1);
+	const char rec[] = "field_one\t\tfield_two\t\t42\t\tLorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor\r\n";
+	for (size_t i = 0; i < n; i++)
+		s[i] = rec[i % (sizeof rec - 1)];
+	s[n] = '\0';
+
+	printf("\n== sreplace (%zu MiB) ==\n", n >> 20);
+	printf(" dense (~%zu matches):\n", 3 * n / (sizeof rec - 1));
+	BENCH("old sreplace (grow)",    runs, n, replace_free(old_sreplace(s, "\t\t", ";;;")));
+	BENCH("sreplace_n (grow)",      runs, n, replace_free(tou_sreplace_n(s, "\t\t", ";;;", NULL)));
+	BENCH("old sreplace (shrink)",  runs, n, replace_free(old_sreplace(s, "\t\t", ";")));
+	BENCH("sreplace_n (shrink)",    runs, n, replace_free(tou_sreplace_n(s, "\t\t", ";", NULL)));
+	BENCH("memcpy + sreplace_inplace", runs, n, tou_sreplace_inplace(memcpy(copy, s, n + 1), "\t\t", ";", NULL));
+	BENCH("memcpy only",            runs, n, memcpy(copy, s, n + 1));
+
+	printf(" sparse (~%zu matches):\n", n / (sizeof rec - 1));
+	BENCH("old sreplace (grow)",    runs, n, replace_free(old_sreplace(s, "\r\n", "\r\n\r\n")));
+	BENCH("sreplace_n (grow)",      runs, n, replace_free(tou_sreplace_n(s, "\r\n", "\r\n\r\n", NULL)));
+	BENCH("memcpy + sreplace_inplace", runs, n, tou_sreplace_inplace(memcpy(copy, s, n + 1), "\r\n", "\n", NULL));
+	free(s);
+	free(copy);
+}
+
+static size_t template_chained(const char* tmpl, const char** from, const char** to, int n)
+{
+	char* str = tou_strdup(tmpl);
+	for (int i = 0; i < n; i++) {
+		char* prev = str;
+		str = tou_sreplace(str, (char*)from[i], (char*)to[i]);
+		free(prev);
+	}
+	return replace_free(str);
+}
+
+static void bench_template(void)
+{
+	enum { N_KEYS = 32 };
+	char from_buf[N_KEYS][16], to_buf[N_KEYS][32];
+	const char* from[N_KEYS];
+	const char* to[N_KEYS];
+	for (int i = 0; i < N_KEYS; i++) {
+		snprintf(from_buf[i], sizeof from_buf[i], "{key%d}", i);
+		snprintf(to_buf[i], sizeof to_buf[i], "value number %d", i);
+		from[i] = from_buf[i];
+		to[i] = to_buf[i];
+	}
+
+	// ~4 MiB template, a placeholder every ~50 bytes
+	tou_sbuf tmpl = {0};
+	for (int i = 0; tmpl.len < 4 * 1024 * 1024; i++)
+		tou_sbuf_appendf(&tmpl, "<p>Some text around the %s placeholder.</p>\n", from[i % N_KEYS]);
+
+	tou_kwset* set = tou_kwset_new(from, N_KEYS);
+	const size_t runs = 4;
+
+	printf("\n== template with %d placeholders (%zu MiB) ==\n", N_KEYS, tmpl.len >> 20);
+	BENCH("sreplace per placeholder", runs, tmpl.len, template_chained(tmpl.data, from, to, N_KEYS));
+	BENCH("sreplace_multi",           runs, tmpl.len, replace_free(tou_sreplace_multi(tmpl.data, from, to, N_KEYS)));
+	BENCH("sreplace_multi_set",       runs, tmpl.len, replace_free(tou_sreplace_multi_set(tmpl.data, set, to, NULL)));
+
+	tou_kwset_destroy(set);
+	tou_sbuf_destroy(&tmpl);
+}
+
+/* A short keyword next to a long one sharing its prefix: every match looks far ahead */
+static void bench_kwset(void)
+{
+	static char long_kwd[4097];
+	memset(long_kwd, 'a', 4095);
+	long_kwd[4095] = 'b';
+	const char* kwds[] = { "a", long_kwd };
+	tou_kwset* set = tou_kwset_new(kwds, 2);
+
+	size_t n = 128 * 1024;
+	char* text = malloc(n + 1);
+	memset(text, 'a', n);
+	text[n] = '\0';
+
+	printf("\n== keyword set {\"a\", 4095 x \"a\" + \"b\"} over %zu KiB of \"a\" ==\n", n >> 10);
+	BENCH("old restart per match", 1, n, old_sfind_all_multiple(text, n, set));
+	BENCH("sfind_all_multiple_n",  4, n, tou_sfind_all_multiple_n(text, set, n, NULL));
+
+	free(text);
+	tou_kwset_destroy(set);
+}
+
+/* Parallel find-all over a buffer where nothing (or something every ~4 KiB) matches */
+static void bench_find_all(void)
+{
+	size_t n = 256 * 1024 * 1024;
+	char* text = malloc(n + 1);
+	if (text == NULL) {
+		printf("\n== sfind_all_parallel: out of memory, skipped ==\n");
+		return;
+	}
+	for (size_t i = 0; i < n; i++)
+		text[i] = 'a' + (char)(i % 23);
+	text[n] = '\0';
+
+	tou_match_list list = {0};
+	list.growable = 1;
+	const size_t runs = 2;
+
+	printf("\n== sfind_all over %zu MiB, no match ==\n", n >> 20);
+	BENCH("sfind_all_n",            runs, n, tou_sfind_all_n(text, "needle", n, &list));
+	BENCH("sfind_all_parallel (1)", runs, n, tou_sfind_all_parallel(text, "needle", n, &list, 1));
+	BENCH("sfind_all_parallel (2)", runs, n, tou_sfind_all_parallel(text, "needle", n, &list, 2));
+	BENCH("sfind_all_parallel (4)", runs, n, tou_sfind_all_parallel(text, "needle", n, &list, 4));
+	BENCH("sfind_all_parallel (8)", runs, n, tou_sfind_all_parallel(text, "needle", n, &list, 8));
+
+	for (size_t i = 4096; i + 6 < n; i += 4096)
+		memcpy(text + i, "needle", 6);
+
+	printf("\n== sfind_all over %zu MiB, a match every 4 KiB ==\n", n >> 20);
+	BENCH("sfind_all_n",            runs, n, tou_sfind_all_n(text, "needle", n, &list));
+	BENCH("sfind_all_parallel (4)", runs, n, tou_sfind_all_parallel(text, "needle", n, &list, 4));
+
+	free(list.items);
+	free(text);
+}
+
+static size_t split_list(char* str, const char* delim)
+{
+	tou_llist_t* list = tou_split(str, delim);
+	size_t n = 0;
+	for (tou_llist_t* e = list; e; e = e->prev)
+		n++;
+	tou_llist_destroy(list);
+	return n;
+}
+
+static void bench_split(void)
+{
+	// One record with ~1M fields
+	tou_sbuf rec = {0};
+	for (int i = 0; i < 1000000; i++)
+		tou_sbuf_appendf(&rec, "%d,", i * 7);
+	char* copy = malloc(rec.len + 1);
+	tou_sv_list views = {0};
+	views.growable = 1;
+	tou_split_views(rec.data, rec.len, ",", &views, 0); // grow `views` up front
+	const size_t runs = 4;
+
+	printf("\n== split of a 1M field record (%zu KiB) ==\n", rec.len >> 10);
+	BENCH("tou_split",                runs, rec.len, split_list(rec.data, ","));
+	BENCH("split_views",              runs, rec.len, tou_split_views(rec.data, rec.len, ",", &views, 0));
+	BENCH("memcpy + split_views (NUL)", runs, rec.len, tou_split_views(memcpy(copy, rec.data, rec.len + 1), rec.len, ",", &views, 1));
+
+	free(views.items);
+	free(copy);
+	tou_sbuf_destroy(&rec);
+}
+
+static void bench_delim(const char* title, const char* line, char delim)
+{
+	// ~8 MiB of lines, split as a whole
+	tou_sbuf text = {0};
+	while (text.len < 8 * 1024 * 1024)
+		tou_sbuf_append(&text, line);
+	const char delim_str[2] = { delim, '\0' };
+	tou_sv_list views = {0};
+	views.growable = 1;
+	tou_split_views(text.data, text.len, delim_str, &views, 0);
+	const size_t runs = 4;
+
+	printf("\n== %s (%zu MiB) ==\n", title, text.len >> 20);
+	BENCH("old split",              runs, text.len, old_split(text.data, delim));
+	BENCH("tou_split",              runs, text.len, split_list(text.data, delim_str));
+	BENCH("old memchr per token",   runs, text.len, old_split_count(text.data, text.len, delim));
+	BENCH("split_views (count)",    runs, text.len, tou_split_views(text.data, text.len, delim_str, NULL, 0));
+	BENCH("split_views",            runs, text.len, tou_split_views(text.data, text.len, delim_str, &views, 0));
+
+	free(views.items);
+	tou_sbuf_destroy(&text);
+}
+
+static void bench_csv(void)
+{
+	bench_delim("CSV on ','", "1234,john.doe@example.com,2024-01-01,GET,/index.html,200,1234,0.051\n", ',');
+	bench_delim("TSV on '\\t'", "1234\tjohn.doe@example.com\t2024-01-01\tGET\t/index.html\t200\t1234\t0.051\n", '\t');
+	bench_delim("lines on '\\n'", "1234,john.doe@example.com,2024-01-01,GET,/index.html,200,1234,0.051\n", '\n');
+}
+
+/* Line by line with tou_split, which is how CSV used to be read (no quoting) */
+static size_t csv_split_lines(char* text)
+{
+	size_t sum = 0;
+	tou_llist_t* lines = tou_split(text, "\n");
+	for (tou_llist_t* l = lines; l; l = l->prev) {
+		tou_llist_t* fields = tou_split(l->dat1, ",");
+		for (tou_llist_t* f = fields; f; f = f->prev)
+			sum += strlen(f->dat1);
+		tou_llist_destroy(fields);
+	}
+	tou_llist_destroy(lines);
+	return sum;
+}
+
+static size_t csv_reader(const char* text, size_t len)
+{
+	size_t sum = 0;
+	tou_csv csv;
+	tou_csv_init(&csv, ',', NULL, NULL);
+	tou_csv_set_buffer(&csv, text, len);
+	while (tou_csv_next_row(&csv)) {
+		for (size_t i = 0; i < csv.n_fields; i++)
+			sum += csv.fields[i].n;
+	}
+	tou_csv_destroy(&csv);
+	return sum;
+}
+
+static void bench_csv_reader(void)
+{
+	// ~32 MiB, every other line has a quoted field with a delimiter and a doubled quote in it
+	tou_sbuf text = {0};
+	for (int i = 0; text.len < 32 * 1024 * 1024; i++) {
+		if (i & 1)
+			tou_sbuf_appendf(&text, "%d,john.doe@example.com,\"Doe, John \"\"JD\"\"\",GET,/index.html,200,0.051\r\n", i);
+		else
+			tou_sbuf_appendf(&text, "%d,jane.roe@example.com,Jane Roe,POST,/api/v1/items,201,0.112\r\n", i);
+	}
+	const size_t runs = 4;
+
+	printf("\n== CSV reader (%zu MiB) ==\n", text.len >> 20);
+	BENCH("split lines, then fields", runs, text.len, csv_split_lines(text.data));
+	BENCH("tou_csv",                  runs, text.len, csv_reader(text.data, text.len));
+
+	tou_sbuf_destroy(&text);
+}
+
+/* Sums the lengths of the first `cols` fields of every line */
+static size_t columns_split(char** lines, size_t n_lines, int cols)
+{
+	size_t sum = 0;
+	for (size_t i = 0; i < n_lines; i++) {
+		tou_llist_t* list = tou_split(lines[i], ",");
+		tou_llist_t* e = list;
+		while (e && e->prev)
+			e = e->prev;
+		for (int c = 0; e && c < cols; e = e->next, c++)
+			sum += strlen(e->dat1);
+		tou_llist_destroy(list);
+	}
+	return sum;
+}
+
+static size_t columns_iter(char** lines, size_t n_lines, int cols)
+{
+	size_t sum = 0;
+	for (size_t i = 0; i < n_lines; i++) {
+		tou_split_iter it;
+		const char* tok;
+		size_t tok_len;
+		tou_split_iter_init(&it, lines[i], 0, ",");
+		for (int c = 0; c < cols && tou_split_iter_next(&it, &tok, &tok_len); c++)
+			sum += tok_len;
+	}
+	return sum;
+}
+
+static void bench_columns(void)
+{
+	enum { N_LINES = 100000 };
+	static const char line[] = "1234,john.doe@example.com,2024-01-01,GET,/index.html,200,1234,0.051,"
+		"Mozilla/5.0,en-US,ok,ok,ok,ok,ok,ok,ok,ok,ok,last";
+	char** lines = malloc(N_LINES * sizeof *lines);
+	for (size_t i = 0; i < N_LINES; i++)
+		lines[i] = tou_strdup(line);
+	size_t bytes = N_LINES * (sizeof line - 1);
+	const size_t runs = 4;
+
+	printf("\n== first 3 of 20 CSV columns, %d lines ==\n", N_LINES);
+	BENCH("tou_split",  runs, bytes, columns_split(lines, N_LINES, 3));
+	BENCH("split_iter", runs, bytes, columns_iter(lines, N_LINES, 3));
+	BENCH("split_iter (all columns)", runs, bytes, columns_iter(lines, N_LINES, 20));
+
+	for (size_t i = 0; i < N_LINES; i++)
+		free(lines[i]);
+	free(lines);
+}
+
+/* Whole-file replace the way it had to be done before sreplace_stream */
+static size_t stream_whole(FILE* in, FILE* out)
+{
+	size_t len = 0;
+	rewind(in);
+	rewind(out);
+	char* data = tou_read_fp(in, &len);
+	char* repl = tou_sreplace_n(data, "\r\n", "\n", &len);
+	fwrite(repl, 1, len, out);
+	free(data);
+	free(repl);
+	return len;
+}
+
+static size_t stream_blocks(FILE* in, FILE* out)
+{
+	rewind(in);
+	rewind(out);
+	return tou_sreplace_stream(in, out, "\r\n", "\n");
+}
+
+static void bench_stream(void)
+{
+	FILE* in = tmpfile();
+	FILE* out = tmpfile();
+	if (in == NULL || out == NULL) {
+		printf("\n== sreplace_stream: no temporary files, skipped ==\n");
+		return;
+	}
+
+	static const char line[] = "2024-01-01T00:00:00Z,GET,/index.html,200,1234\r\n";
+	size_t n = 0;
+	while (n < 32 * 1024 * 1024)
+		n += fwrite(line, 1, sizeof line - 1, in);
+	fflush(in);
+
+	const size_t runs = 4;
+	printf("\n== CRLF -> LF over a %zu MiB file ==\n", n >> 20);
+	BENCH("read_fp + sreplace_n", runs, n, stream_whole(in, out));
+	BENCH("sreplace_stream",      runs, n, stream_blocks(in, out));
+
+	fclose(in);
+	fclose(out);
+}
+
+
+/* Loads the file and counts its lines, so mapped pages are actually touched */
+static size_t load_read_file(const char* path)
+{
+	size_t len = 0;
+	char* data = tou_read_file(path, &len);
+	size_t lines = tou_scount_n(data, "\n", len);
+	free(data);
+	return lines;
+}
+
+static size_t load_map_file(const char* path, int flags)
+{
+	tou_mapped_file f;
+	if (tou_map_file(path, &f, flags) != 0)
+		return 0;
+	size_t lines = tou_scount_n(f.data, "\n", f.len);
+	tou_unmap_file(&f);
+	return lines;
+}
+
+static void bench_map(void)
+{
+#ifdef _WIN32
+	printf("\n== map_file: no mmap on this platform, skipped ==\n");
+#else
+	char path[] = "/tmp/tou_bench_XXXXXX";
+	int fd = mkstemp(path);
+	FILE* fp = (fd < 0) ? NULL : fdopen(fd, "wb");
+	if (fp == NULL) {
+		printf("\n== map_file: no temporary file, skipped ==\n");
+		return;
+	}
+
+	static const char line[] = "aardvark\t1\tnoun\tan African burrowing mammal\n";
+	size_t n = 0;
+	while (n < 64 * 1024 * 1024)
+		n += fwrite(line, 1, sizeof line - 1, fp);
+	fclose(fp);
+
+	const size_t runs = 8;
+	printf("\n== Loading a %zu MiB file and counting lines ==\n", n >> 20);
+	BENCH("read_file",                runs, n, load_read_file(path));
+	BENCH("map_file",                 runs, n, load_map_file(path, TOU_MAP_READONLY));
+	BENCH("map_file (SEQUENTIAL)",    runs, n, load_map_file(path, TOU_MAP_SEQUENTIAL));
+	BENCH("map_file (WILLNEED)",      runs, n, load_map_file(path, TOU_MAP_WILLNEED));
+
+	remove(path);
+#endif
+}
+
+
+/* Reads the whole file with `read_fn` from the start */
+static size_t read_whole(FILE* fp, char* (*read_fn)(FILE*, size_t*))
+{
+	size_t len = 0;
+	rewind(fp);
+	free(read_fn(fp, &len));
+	return len;
+}
+
+/* Same, but through a pipe-like stream of unknown size */
+static size_t read_piped(const char* cmd, char* (*read_fn)(FILE*, size_t*))
+{
+	size_t len = 0;
+	FILE* fp = popen(cmd, "r");
+	if (fp == NULL)
+		return 0;
+	free(read_fn(fp, &len));
+	pclose(fp);
+	return len;
+}
+
+static void bench_read_size(size_t size, size_t runs)
+{
+	FILE* fp = tmpfile();
+	if (fp == NULL) {
+		printf("\n== read_fp: no temporary file, skipped ==\n");
+		return;
+	}
+
+	static char chunk[1 << 20];
+	memset(chunk, 'x', sizeof chunk);
+	size_t n = 0;
+	while (n < size) {
+		size_t want = (size - n < sizeof chunk) ? size - n : sizeof chunk;
+		size_t cnt = fwrite(chunk, 1, want, fp);
+		if (cnt == 0)
+			break;
+		n += cnt;
+	}
+	fflush(fp);
+	if (n < size) {
+		printf("\n== read_fp: could not write %zu MiB, skipped ==\n", size >> 20);
+		fclose(fp);
+		return;
+	}
+
+	char cmd[64];
+	snprintf(cmd, sizeof cmd, "head -c %zu /dev/zero", size);
+
+	printf("\n== Reading a %zu MiB file ==\n", size >> 20);
+	BENCH("old read_fp",        runs, n, read_whole(fp, old_read_fp));
+	BENCH("read_fp",            runs, n, read_whole(fp, tou_read_fp));
+	BENCH("old read_fp (pipe)", runs, n, read_piped(cmd, old_read_fp));
+	BENCH("read_fp (pipe)",     runs, n, read_piped(cmd, tou_read_fp));
+
+	fclose(fp);
+}
+
+static void bench_read(void)
+{
+	bench_read_size((size_t)1 << 20, 200);
+	bench_read_size((size_t)100 << 20, 4);
+	if (sizeof(size_t) > 4)
+		bench_read_size((size_t)2048 << 20, 1);
+}
+
+
+/* Cheap per-block work so the read itself dominates */
+static void* blocks_touch(void* blockdata, void* len, void* userdata)
+{
+	*(size_t*)userdata += ((unsigned char*)blockdata)[(size_t)len - 1];
+	return (void*)TOU_CONTINUE;
+}
+
+static size_t blocks_old(FILE* fp, size_t blocksize)
+{
+	size_t sum = 0;
+	rewind(fp);
+	return old_read_fp_in_blocks(fp, blocksize, blocks_touch, &sum) + sum;
+}
+
+static size_t blocks_fp(FILE* fp, size_t blocksize)
+{
+	size_t sum = 0;
+	rewind(fp);
+	return tou_read_fp_in_blocks(fp, blocksize, blocks_touch, &sum) + sum;
+}
+
+#ifndef _WIN32
+static size_t blocks_fd(tou_block_reader* r, int fd)
+{
+	size_t sum = 0;
+	tou_block_reader_set_fd(r, fd, 1, 0);
+	return tou_block_reader_run(r, blocks_touch, &sum) + sum;
+}
+#endif
+
+static void bench_blocks(void)
+{
+	FILE* fp = tmpfile();
+	if (fp == NULL) {
+		printf("\n== read_fp_in_blocks: no temporary file, skipped ==\n");
+		return;
+	}
+
+	static char chunk[1 << 20];
+	memset(chunk, 'x', sizeof chunk);
+	size_t n = 0;
+	while (n < 256 * 1024 * 1024)
+		n += fwrite(chunk, 1, sizeof chunk, fp);
+	fflush(fp);
+
+	static const size_t sizes[] = { 64 * 1024, 1024 * 1024, 4 * 1024 * 1024 };
+	const size_t runs = 4;
+	for (size_t i = 0; i < TOU_ARRSIZE(sizes); i++) {
+		printf("\n== Reading a %zu MiB file in %zu KiB blocks ==\n", n >> 20, sizes[i] >> 10);
+		BENCH("old read_fp_in_blocks", runs, n, blocks_old(fp, sizes[i]));
+		BENCH("read_fp_in_blocks",     runs, n, blocks_fp(fp, sizes[i]));
+#ifndef _WIN32
+		tou_block_reader r;
+		if (tou_block_reader_init(&r, sizes[i], NULL) == 0) {
+			BENCH("block_reader (pread)", runs, n, blocks_fd(&r, fileno(fp)));
+			tou_block_reader_destroy(&r);
+		}
+#endif
+	}
+
+	fclose(fp);
+}
+
+
+/* Per-block parse work: count the lines */
+static void* ahead_count(void* blockdata, void* len, void* userdata)
+{
+	*(size_t*)userdata += tou_scount_n((const char*)blockdata, "\n", (size_t)len);
+	return (void*)TOU_CONTINUE;
+}
+
+static size_t ahead_serial(FILE* fp)
+{
+	size_t lines = 0;
+	rewind(fp);
+	tou_read_fp_in_blocks(fp, 1024 * 1024, ahead_count, &lines);
+	return lines;
+}
+
+static size_t ahead_pipelined(FILE* fp, int nbuffers)
+{
+	size_t lines = 0;
+	rewind(fp);
+	tou_read_fp_in_blocks_ahead(fp, 1024 * 1024, nbuffers, ahead_count, &lines);
+	return lines;
+}
+
+static void bench_ahead(void)
+{
+	FILE* fp = tmpfile();
+	if (fp == NULL) {
+		printf("\n== read_fp_in_blocks_ahead: no temporary file, skipped ==\n");
+		return;
+	}
+
+	static const char line[] = "2024-01-01T00:00:00Z,GET,/index.html,200,1234\n";
+	size_t n = 0;
+	while (n < 256 * 1024 * 1024)
+		n += fwrite(line, 1, sizeof line - 1, fp);
+	fflush(fp);
+
+	const size_t runs = 4;
+	printf("\n== Counting lines of a %zu MiB file in 1 MiB blocks ==\n", n >> 20);
+	BENCH("read_fp_in_blocks",            runs, n, ahead_serial(fp));
+	BENCH("read_fp_in_blocks_ahead (2)",  runs, n, ahead_pipelined(fp, 2));
+	BENCH("read_fp_in_blocks_ahead (4)",  runs, n, ahead_pipelined(fp, 4));
+
+	fclose(fp);
+}
+
+
+/* CPU-heavy map stage: FNV-1a over the block */
+static void* pblocks_hash(void* blockdata, void* len, void* userdata)
+{
+	(void)userdata;
+	const unsigned char* p = (const unsigned char*)blockdata;
+	uint64_t h = 1469598103934665603ULL;
+	for (size_t i = 0; i < (size_t)len; i++)
+		h = (h ^ p[i]) * 1099511628211ULL;
+	return (void*)(uintptr_t)h;
+}
+
+static void* pblocks_combine(void* result, void* index, void* userdata)
+{
+	(void)index;
+	*(size_t*)userdata = *(size_t*)userdata * 31 + (size_t)(uintptr_t)result;
+	return (void*)TOU_CONTINUE;
+}
+
+static size_t pblocks_run(FILE* fp, int nthreads)
+{
+	size_t sum = 0;
+	rewind(fp);
+	tou_read_fp_in_blocks_parallel(fp, 1024 * 1024, pblocks_hash, pblocks_combine, &sum, nthreads);
+	return sum;
+}
+
+static void bench_parallel_blocks(void)
+{
+	FILE* fp = tmpfile();
+	if (fp == NULL) {
+		printf("\n== read_fp_in_blocks_parallel: no temporary file, skipped ==\n");
+		return;
+	}
+
+	static char chunk[1 << 20];
+	for (size_t i = 0; i < sizeof chunk; i++)
+		chunk[i] = (char)(i * 7);
+	size_t n = 0;
+	while (n < 128 * 1024 * 1024)
+		n += fwrite(chunk, 1, sizeof chunk, fp);
+	fflush(fp);
+
+	const size_t runs = 2;
+	printf("\n== Hashing a %zu MiB file in 1 MiB blocks (%d CPUs) ==\n", n >> 20, _tou_cpu_count());
+	BENCH("1 thread",  runs, n, pblocks_run(fp, 1));
+	BENCH("2 threads", runs, n, pblocks_run(fp, 2));
+	BENCH("4 threads", runs, n, pblocks_run(fp, 4));
+	BENCH("per CPU",   runs, n, pblocks_run(fp, 0));
+
+	fclose(fp);
+}
+
+
+int main(int argc, char const* argv[])
+{
+	(void)argc; (void)argv;
+
+	bench_strchr();
+	bench_trim();
+	bench_translate();
+	bench_prepend();
+	bench_sreplace();
+	bench_template();
+	bench_kwset();
+	bench_find_all();
+	bench_split();
+	bench_columns();
+	bench_csv();
+	bench_csv_reader();
+	bench_stream();
+	bench_read();
+	bench_blocks();
+	bench_ahead();
+	bench_parallel_blocks();
+	bench_map();
+
+	printf("\nDone.\n");
+	return 0;
+}
@@ -4,6 +4,7 @@
 
 #define TOU_IMPLEMENTATION
 #define TOU_DBG 0
+#define _TOU_SREPLACE_STREAM_BLOCKSIZE 8 // tiny blocks so tou_sreplace_stream() matches span them
 /* #define TOU_LLIST_SINGLE_ELEM */
 #include "tou.h"
 
@@ -34,6 +35,67 @@ void* cb_ini2(void* ptr, void* userdata)
 	return (void*) TOU_CONTINUE;
 } 
 
+ void* cb_kwd(void* found, void* kwd, void* userdata)
+{
+	printf("- (cb_kwd) Keyword <%s> at %d\n", (char*)kwd, (int)((char*)found - (char*)userdata));
+	return (void*) TOU_CONTINUE;
+}
+
+ void* cb_stream_match(void* match, void* kwd, void* userdata)
+{
+	tou_match* m = (tou_match*) match;
+	printf("- (cb_stream_match) Keyword <%s> at offset %zu\n", (char*)kwd, m->offset);
+	return (void*) TOU_CONTINUE;
+}
+
+ void* cb_fileread_stop(void* blockdata, void* len, void* userdata)
+{
+	size_t* blocks_left = (size_t*) userdata;
+	if (--*blocks_left == 0)
+		return (void*) TOU_BREAK;
+	return (void*) TOU_CONTINUE;
+}
+
+typedef struct {
+	size_t next_index;
+	tou_block_store_struct joined;
+} block_join_t;
+
+ void* cb_map_copy(void* blockdata, void* len, void* userdata)
+{
+	tou_block_store_struct* part = calloc(1, sizeof(tou_block_store_struct));
+	if (part)
+		tou_block_store_cb(blockdata, len, part);
+	return part;
+}
+
+ void* cb_reduce_join(void* result, void* index, void* userdata)
+{
+	tou_block_store_struct* part = (tou_block_store_struct*) result;
+	block_join_t* join = (block_join_t*) userdata;
+	void* action = (void*) TOU_BREAK;
+
+	// Blocks must come back in file order
+	if (part && (size_t) index == join->next_index++)
+		action = tou_block_store_cb(part->buffer, (void*) part->size, &join->joined);
+
+	if (part)
+		free(part->buffer);
+	free(part);
+	return action;
+}
+
+ void* cb_csv_row(void* fields, void* n_fields, void* userdata)
+{
+	tou_sv* f = (tou_sv*) fields;
+	size_t* rows = (size_t*) userdata;
+	printf("- (cb_csv_row) Row %zu:", (*rows)++);
+	for (size_t i = 0; i < (size_t) n_fields; i++)
+		printf(" <%.*s>", (int) f[i].n, f[i].p);
+	printf("\n");
+	return (void*) TOU_CONTINUE;
+}
+
  void* cb_fileread(void* blockdata, void* len, void* userdata)
 {
 	char* block = (char*) blockdata;
@@ -95,8 +157,8 @@ printf("\n");
 	printf("\n2.) tou_read_fp_in_blocks contents (%zu):\n%s", siz, contents);
 	free(contents); contents = NULL;
 
-	// 3. Use tou-defined func+struct for reading FILE* (this is how tou_read_file() is implemented) //
-	tou_block_store_struct my_data_buf = {NULL, 0};
+	// 3. Use tou-defined func+struct for collecting all blocks of a FILE* into one buffer //
+	tou_block_store_struct my_data_buf = {NULL, 0, 0};
 	
 	fptr = fopen("testfile.txt", "rb");
 	tou_read_fp_in_blocks(fptr, -1, tou_block_store_cb, &my_data_buf); // default block size, without function
@@ -111,6 +173,92 @@ printf("\n");
 	printf("4.) File size: %zu\n", tou_read_fp_in_blocks(fptr, 0,0,0));
 	fclose(fptr); fptr = NULL;
 
+	// 5. Match keywords while reading in (tiny) blocks; matches may span blocks //
+	const char* stream_kwds[] = {"def", "ooop1", "789"};
+	tou_kwset* stream_set = tou_kwset_new(stream_kwds, TOU_ARRSIZE(stream_kwds));
+	tou_kwset_stream stream;
+	tou_kwset_stream_init(&stream, stream_set, cb_stream_match, NULL);
+
+	printf("5.) Matching keywords in 8-byte blocks:\n");
+	fptr = fopen("testfile.txt", "rb");
+	tou_read_fp_in_blocks(fptr, 8, tou_kwset_stream_cb, &stream);
+	tou_kwset_stream_finish(&stream);
+	fclose(fptr); fptr = NULL;
+	tou_kwset_destroy(stream_set);
+
+	// 6. Read ahead on a background thread; blocks must arrive as with tou_read_fp_in_blocks() //
+	tou_block_store_struct serial_buf = {NULL, 0, 0}, ahead_buf = {NULL, 0, 0};
+	size_t serial_siz, blocks_left;
+
+	fptr = fopen("testfile.txt", "rb");
+	serial_siz = tou_read_fp_in_blocks(fptr, 8, tou_block_store_cb, &serial_buf);
+	fclose(fptr); fptr = NULL;
+
+	fptr = fopen("testfile.txt", "rb");
+	siz = tou_read_fp_in_blocks_ahead(fptr, 8, 3, tou_block_store_cb, &ahead_buf);
+	fclose(fptr); fptr = NULL;
+	printf("6.) tou_read_fp_in_blocks_ahead read %zu of %zu bytes, same data: %s\n", siz, serial_siz,
+		(siz == serial_siz && ahead_buf.size == serial_buf.size && memcmp(ahead_buf.buffer, serial_buf.buffer, siz) == 0) ? "yes" : "no");
+	free(ahead_buf.buffer); ahead_buf = (tou_block_store_struct){NULL, 0, 0};
+
+	blocks_left = 2;
+	fptr = fopen("testfile.txt", "rb");
+	siz = tou_read_fp_in_blocks_ahead(fptr, 8, 3, cb_fileread_stop, &blocks_left);
+	fclose(fptr); fptr = NULL;
+	printf("    stopped with TOU_BREAK after 2 blocks: %zu bytes\n", siz);
+
+	// 7. Same through a block reader //
+	tou_block_reader reader;
+	tou_block_reader_init(&reader, 8, NULL);
+	fptr = fopen("testfile.txt", "rb");
+	tou_block_reader_set_fp(&reader, fptr);
+	siz = tou_block_reader_run_ahead(&reader, 2, tou_block_store_cb, &ahead_buf);
+	fclose(fptr); fptr = NULL;
+	printf("7.) tou_block_reader_run_ahead read %zu of %zu bytes, same data: %s\n", siz, serial_siz,
+		(siz == serial_siz && ahead_buf.size == serial_buf.size && memcmp(ahead_buf.buffer, serial_buf.buffer, siz) == 0) ? "yes" : "no");
+	free(ahead_buf.buffer); ahead_buf = (tou_block_store_struct){NULL, 0, 0};
+
+	blocks_left = 3;
+	fptr = fopen("testfile.txt", "rb");
+	tou_block_reader_set_fp(&reader, fptr);
+	siz = tou_block_reader_run_ahead(&reader, 4, cb_fileread_stop, &blocks_left);
+	fclose(fptr); fptr = NULL;
+	printf("    stopped with TOU_BREAK after 3 blocks: %zu bytes\n", siz);
+	tou_block_reader_destroy(&reader);
+
+	// 8. Copy blocks on worker threads and join them back together in order //
+	block_join_t join = {0, {NULL, 0, 0}};
+	fptr = fopen("testfile.txt", "rb");
+	siz = tou_read_fp_in_blocks_parallel(fptr, 8, cb_map_copy, cb_reduce_join, &join, 4);
+	fclose(fptr); fptr = NULL;
+	printf("8.) tou_read_fp_in_blocks_parallel read %zu of %zu bytes in %zu blocks, same data: %s\n", siz, serial_siz, join.next_index,
+		(siz == serial_siz && join.joined.size == serial_buf.size && memcmp(join.joined.buffer, serial_buf.buffer, siz) == 0) ? "yes" : "no");
+	free(join.joined.buffer); join.joined.buffer = NULL;
+
+	blocks_left = 2;
+	fptr = fopen("testfile.txt", "rb");
+	siz = tou_read_fp_in_blocks_parallel(fptr, 8, NULL, cb_fileread_stop, &blocks_left, 4);
+	fclose(fptr); fptr = NULL;
+	printf("    stopped with TOU_BREAK after 2 blocks: %zu bytes\n", siz);
+
+	// 9. Map the file instead of reading it; a writable mapping is a private copy //
+	tou_mapped_file mapped;
+	if (tou_map_file("testfile.txt", &mapped, TOU_MAP_SEQUENTIAL | TOU_MAP_WILLNEED) == 0) {
+		printf("9.) tou_map_file mapped %zu of %zu bytes (mapped=%d), same data: %s\n", mapped.len, serial_siz, mapped.mapped,
+			(mapped.len == serial_buf.size && memcmp(mapped.data, serial_buf.buffer, mapped.len) == 0) ? "yes" : "no");
+		tou_unmap_file(&mapped);
+	}
+	if (tou_map_file("testfile.txt", &mapped, TOU_MAP_WRITABLE) == 0) {
+		mapped.data[0] = '#';
+		tou_unmap_file(&mapped);
+		contents = tou_read_file("testfile.txt", &siz);
+		printf("    file after writing to a writable mapping unchanged: %s\n",
+			(siz == serial_buf.size && memcmp(contents, serial_buf.buffer, siz) == 0) ? "yes" : "no");
+		free(contents); contents = NULL;
+	}
+
+	free(serial_buf.buffer); serial_buf.buffer = NULL;
+
 
 printf("\n\n");
 printf("========================================\n"
@@ -360,6 +508,13 @@ printf("\n");
 		printf("Key: |%s|  Val: |%s|\n", key, val);
 	}
 
+// Find substring ignoring (ASCII) case //
+	const char* ci_text = "Key = Some VALUE";
+	char* ci_found = tou_sfind_ci(ci_text, "some value");
+	printf("== 'some value' ignoring case in '%s': %s\n", ci_text, ci_found ? ci_found : "(not found)");
+	ci_found = tou_sfind_ci(ci_text, "other");
+	printf("== 'other' ignoring case in '%s': %s\n", ci_text, ci_found ? ci_found : "(not found)");
+
 
 printf("\n\n");
 printf("========================================\n"
@@ -388,6 +543,75 @@ printf("\n");
 
 	tou_llist_destroy(splitted);
 
+// Search for many keywords at once using a compiled keyword set //
+	const char* kwset_kwds[] = {"123", "def", "de", ";"};
+	tou_kwset* kwset = tou_kwset_new(kwset_kwds, TOU_ARRSIZE(kwset_kwds));
+	printf("== Iterating keyword set matches in '%s':\n", str);
+	tou_kwset_iter(kwset, str, cb_kwd, str);
+	tou_kwset_destroy(kwset);
+
+// Split into views without copying; empty fields are kept, a trailing delimiter adds no token (as with tou_split) //
+	char views_str[] = "a,,bc,d,";
+	tou_sv views_buf[8];
+	tou_sv_list views = {views_buf, 0, TOU_ARRSIZE(views_buf), 0};
+	printf("== Views of '%s' split by ',':\n", views_str);
+	size_t n_views = tou_split_views(views_str, 0, ",", &views, 0);
+	for (size_t i = 0; i < views.count; i++)
+		printf("- View <%.*s> (len %zu)\n", (int) views.items[i].n, views.items[i].p, views.items[i].n);
+	printf("%zu tokens, source untouched: |%s|\n", n_views, views_str);
+
+	tou_sv_list views_small = {views_buf, 0, 2, 0};
+	n_views = tou_split_views(views_str, 0, ",", &views_small, 0);
+	printf("With room for 2 views: %zu stored, %zu counted\n", views_small.count, n_views);
+
+	printf("== Same views NUL-terminated in place:\n");
+	n_views = tou_split_views(views_str, sizeof(views_str) - 1, ",", &views, 1);
+	for (size_t i = 0; i < views.count; i++)
+		printf("- Token <%s>\n", views.items[i].p);
+	printf("%zu tokens\n", n_views);
+
+// Split lazily, one token at a time //
+	const char* iter_str = ";;x;;yz;";
+	tou_split_iter split_it;
+	const char* tok;
+	size_t tok_len;
+	printf("== Iterating '%s' split by ';':\n", iter_str);
+	tou_split_iter_init(&split_it, iter_str, 0, ";");
+	while (tou_split_iter_next(&split_it, &tok, &tok_len))
+		printf("- Token <%.*s> at %d\n", (int) tok_len, tok, (int) (tok - iter_str));
+
+
+	// CSV test //
+printf("\n\n");
+printf("========================================\n"
+       "|           CSV READER TEST            |\n"
+       "========================================\n");
+printf("\n");
+
+	const char csv_text[] = "name,qty,note\r\nbolt,12,\"M4, zinc\"\nnut,,\"say \"\"hi\"\"\"\n\"multi\nline\",3,end";
+	tou_csv csv;
+
+// Pull rows out of a whole buffer //
+	printf("== Rows from buffer:\n");
+	tou_csv_init(&csv, ',', NULL, NULL);
+	tou_csv_set_buffer(&csv, csv_text, sizeof(csv_text) - 1);
+	while (tou_csv_next_row(&csv)) {
+		printf("- Row %zu:", csv.rows - 1);
+		for (size_t i = 0; i < csv.n_fields; i++)
+			printf(" <%.*s>", (int) csv.fields[i].n, csv.fields[i].p);
+		printf("\n");
+	}
+	tou_csv_destroy(&csv);
+
+// Push the same text in 5-byte chunks; rows must come out the same //
+	size_t csv_rows = 0;
+	printf("== Rows from 5-byte chunks:\n");
+	tou_csv_init(&csv, ',', cb_csv_row, &csv_rows);
+	for (size_t i = 0; i < sizeof(csv_text) - 1; i += 5)
+		tou_csv_feed(&csv, csv_text + i, (sizeof(csv_text) - 1 - i < 5) ? sizeof(csv_text) - 1 - i : 5);
+	tou_csv_finish(&csv);
+	tou_csv_destroy(&csv);
+
 
 	// Character/string replacing test //
 printf("\n\n");
@@ -412,6 +636,139 @@ printf("\n");
 	tou_replace_ch(repl_ss, 'o', 'F');
 	printf("original at the end = %s\n", repl_ss);
 
+// Build a string piece by piece with a string builder //
+	tou_sbuf sb = {0};
+	for (int i = 0; i < 5; i++) {
+		tou_sbuf_appendf(&sb, "%d", i);
+		tou_sbuf_appendch(&sb, ',');
+	}
+	tou_sbuf_append(&sb, repl_ss);
+	char* built = tou_sbuf_detach(&sb);
+	printf("built with sbuf = %s\n", built);
+	free(built);
+
+
+	// In-place replace test //
+printf("\n\n");
+printf("========================================\n"
+       "|     IN-PLACE STRING REPLACE TEST     |\n"
+       "========================================\n");
+printf("\n");
+
+	char inpl[] = "one, two, three, four";
+	size_t inpl_len;
+	printf("original = |%s|\n", inpl);
+
+// Shorter replacement: the string shrinks //
+	inpl_len = 0;
+	tou_sreplace_inplace(inpl, ", ", ";", &inpl_len);
+	printf("', ' -> ';' = |%s| (len %zu)\n", inpl, inpl_len);
+
+// Same length: nothing moves //
+	inpl_len = 0;
+	tou_sreplace_inplace(inpl, "o", "0", &inpl_len);
+	printf("'o' -> '0' = |%s| (len %zu)\n", inpl, inpl_len);
+
+// Only the first `len` bytes are searched, the rest is moved along //
+	inpl_len = 8;
+	tou_sreplace_inplace(inpl, ";", "", &inpl_len);
+	printf("';' -> '' in the first 8 = |%s| (len %zu)\n", inpl, inpl_len);
+
+// Matches at both ends and a string that is all matches //
+	char inpl_ends[] = "xaxxbx";
+	inpl_len = 0;
+	tou_sreplace_inplace(inpl_ends, "x", "", &inpl_len);
+	printf("'x' -> '' in 'xaxxbx' = |%s| (len %zu)\n", inpl_ends, inpl_len);
+	char inpl_all[] = "abab";
+	inpl_len = 0;
+	tou_sreplace_inplace(inpl_all, "ab", "", &inpl_len);
+	printf("'ab' -> '' in 'abab' = |%s| (len %zu)\n", inpl_all, inpl_len);
+
+// Longer replacement doesn't fit: NULL, and the string is left alone //
+	inpl_len = 0;
+	char* inpl_res = tou_sreplace_inplace(inpl, "e", "eee", &inpl_len);
+	printf("'e' -> 'eee' returned %s, string still |%s|\n", inpl_res ? "the string" : "NULL", inpl);
+
+
+	// Multi-keyword replace test //
+printf("\n\n");
+printf("========================================\n"
+       "|      MULTI-KEYWORD REPLACE TEST      |\n"
+       "========================================\n");
+printf("\n");
+
+// Overlapping keywords: the leftmost match wins, then the longest one //
+	const char* multi_from[] = {"he", "hers", "she"};
+	const char* multi_to[]   = {"[he]", "[hers]", "[she]"};
+	const char multi_text[] = "ushers and hershey, he said";
+	printf("original = |%s|\n", multi_text);
+
+	char* multi_res = tou_sreplace_multi(multi_text, multi_from, multi_to, TOU_ARRSIZE(multi_from));
+	printf("sreplace_multi     = |%s|\n", multi_res);
+	free(multi_res);
+
+// Same keywords compiled once and reused //
+	tou_kwset* multi_set = tou_kwset_new(multi_from, TOU_ARRSIZE(multi_from));
+	size_t multi_len = 0;
+	multi_res = tou_sreplace_multi_set(multi_text, multi_set, multi_to, &multi_len);
+	printf("sreplace_multi_set = |%s| (len %zu)\n", multi_res, multi_len);
+	free(multi_res);
+
+// Output handed over piece by piece, or written to a stream //
+	tou_block_store_struct multi_buf = {NULL, 0, 0};
+	size_t multi_cnt = tou_sreplace_multi_cb(multi_text, sizeof(multi_text) - 1, multi_set, multi_to, tou_block_store_cb, &multi_buf);
+	printf("sreplace_multi_cb  = |%s| (%zu bytes)\n", multi_buf.buffer, multi_cnt);
+	free(multi_buf.buffer); multi_buf.buffer = NULL;
+
+	printf("sreplace_multi_fp  = |");
+	multi_cnt = tou_sreplace_multi_fp(multi_text, sizeof(multi_text) - 1, multi_set, multi_to, stdout);
+	printf("| (%zu bytes)\n", multi_cnt);
+	tou_kwset_destroy(multi_set);
+
+
+	// Stream replace test //
+printf("\n\n");
+printf("========================================\n"
+       "|         STREAM REPLACE TEST          |\n"
+       "========================================\n");
+printf("\n");
+
+// Replace while copying between streams read in 8-byte blocks; shifting the
+// text moves the matches across every block boundary position //
+	const char stream_text[] = "line1<br>line2<br><br><b<br>>tail<br";
+	printf("input = |%s|\n", stream_text);
+	int stream_same = 1;
+	for (int shift = 0; shift < 8; shift++) {
+		char shifted[64];
+		sprintf(shifted, "%.*s%s", shift, "-------", stream_text);
+
+		FILE* stream_in = tmpfile();
+		FILE* stream_out = tmpfile();
+		if (!stream_in || !stream_out) {
+			printf("cannot create temporary files\n");
+			stream_same = 0;
+			break;
+		}
+		fputs(shifted, stream_in);
+		rewind(stream_in);
+		size_t stream_cnt = tou_sreplace_stream(stream_in, stream_out, "<br>", "\n");
+		rewind(stream_out);
+		char* stream_res = tou_read_fp(stream_out, NULL);
+		fclose(stream_in);
+		fclose(stream_out);
+
+		char* whole_res = tou_sreplace(shifted, "<br>", "\n");
+		if (shift == 0)
+			printf("'<br>' -> '\\n' (%zu replacements) =\n%s|\n", stream_cnt, stream_res);
+		if (!stream_res || !whole_res || strcmp(stream_res, whole_res) != 0) {
+			printf("shifted by %d: differs from tou_sreplace\n", shift);
+			stream_same = 0;
+		}
+		free(stream_res);
+		free(whole_res);
+	}
+	printf("same as tou_sreplace for all 8 shifts: %s\n", stream_same ? "yes" : "no");
+
 
 	// .INI test //
 printf("\n\n");